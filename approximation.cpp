@@ -3,6 +3,7 @@
  * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
  */
 #include <vector>
+#include <string>
 #include "v_image.h"
 #include "config.h"
 #include "parameters.h"
@@ -10,10 +11,14 @@
 #include "least_squares_simple.h"
 #include "least_squares_opencv.h"
 #include "approximation.h"
+#include "metrics.h"
 
 namespace vectorix {
 
+const std::vector<std::string> approximation::used_params = {"export_type", "lsq_method", "approximation_error", "approximation_iterations", "approximation_preserve_corners", "auto_contour_variance", "offset_error", "offset_iterations"};
+
 void approximation::run(v_image &image) {
+	stage_timer time("approximation");
 	geom::convert_to_variable_width(image, *param_export_type, *par); // Convert image before writing
 
 	for (v_line &li: image.line) {
@@ -210,6 +215,7 @@ bool approximation::optimize_control_point_lengths(const std::vector<v_pt> &poin
 
 		// 4
 		iteration++;
+		count(counter::approximation_iterations);
 
 		// 5
 		if (error < *param_approximation_error) {
@@ -6,6 +6,7 @@
 #define VECTORIX__APPROXIMATION_H
 
 #include <vector>
+#include <string>
 #include "v_image.h"
 #include "config.h"
 #include "parameters.h"
@@ -35,6 +36,8 @@ public:
 		param_approximation_iterations = &iterations;
 	};
 	void run(v_image &image);
+
+	static const std::vector<std::string> used_params; // Parameters which change output of run() (including conversion to variable-width)
 private:
 	int *param_lsq_method;
 	int *param_export_type;
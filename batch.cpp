@@ -0,0 +1,189 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "batch.h"
+#include "job.h"
+#include "parameters.h"
+#include "logger.h"
+#include "timer.h"
+#include "parallel.h"
+#include "pipeline.h"
+
+// Batch mode: vectorize many images in one process
+
+namespace vectorix {
+
+void batch::list_inputs(std::vector<std::string> &names) {
+	struct stat st;
+	if (stat(param_batch_input->c_str(), &st) != 0) {
+		log.log<log_level::error>("Batch input \"%s\" does not exist.\n", param_batch_input->c_str());
+		throw std::invalid_argument("Unable to read batch input.");
+	}
+
+	if (S_ISDIR(st.st_mode)) { // Every regular file in directory
+		DIR *dir = opendir(param_batch_input->c_str());
+		if (!dir)
+			throw std::invalid_argument("Unable to read batch input directory.");
+		while (struct dirent *entry = readdir(dir)) {
+			if (entry->d_name[0] == '.') // Skip hidden files, "." and ".."
+				continue;
+			std::string name = *param_batch_input + "/" + entry->d_name;
+			if ((stat(name.c_str(), &st) == 0) && S_ISREG(st.st_mode))
+				names.push_back(name);
+		}
+		closedir(dir);
+		std::sort(names.begin(), names.end()); // Same order on every run
+	}
+	else { // List file, one image per line
+		FILE *fd = fopen(param_batch_input->c_str(), "r");
+		if (!fd)
+			throw std::invalid_argument("Unable to read batch input list.");
+		char *line;
+		while (fscanf(fd, "%m[^\n]\n", &line) >= 0) {
+			if (!line) // Skip empty line
+				continue;
+			if (line[0] != '#') // Skip commented line
+				names.push_back(line);
+			free(line);
+		}
+		fclose(fd);
+	}
+}
+
+std::string batch::output_name(const std::string &input_name, int output_engine) {
+	std::string name = input_name;
+	if (!param_batch_output->empty()) // Drop input directory
+		name = name.substr(name.rfind('/') + 1);
+	size_t slash = name.rfind('/');
+	size_t dot = name.rfind('.');
+	if ((dot != std::string::npos) && ((slash == std::string::npos) || (dot > slash)))
+		name = name.substr(0, dot); // Drop extension
+	if (!param_batch_output->empty())
+		name = *param_batch_output + "/" + name;
+	return name + ((output_engine == 0) ? ".svg" : ".ps");
+}
+
+void batch::save(job &j, const std::string &name) {
+	int *output_engine;
+	j.par.bind_param(output_engine, "output_engine", 0);
+
+	std::string out_name = output_name(name, *output_engine);
+	FILE *fd = fopen(out_name.c_str(), "w");
+	if (!fd)
+		throw std::invalid_argument("Unable to open output file.");
+	j.write(fd);
+	fclose(fd);
+}
+
+void batch::process(const parameters &snapshot, const std::string &name, double &time, std::string &error, metrics &met) {
+	try {
+		job j(snapshot);
+		j.load(name);
+		j.vectorize();
+		time = j.vectorization_time;
+		save(j, name);
+		met = j.met;
+	}
+	catch (const std::exception &e) {
+		error = e.what();
+	}
+	catch (const char *e) { // Vectorizer throws plain strings
+		error = e;
+	}
+	catch (...) {
+		error = "Unknown error.";
+	}
+}
+
+int batch::run() {
+	std::vector<std::string> names;
+	list_inputs(names);
+
+	parameters snapshot(*par); // One parsed snapshot of parameters, every job makes its own copy
+
+	int workers = worker_count(*param_batch_workers, names.size());
+	log.log<log_level::info>("Batch: %i images, %i workers\n", names.size(), workers);
+
+	std::vector<double> times(names.size(), 0);
+	std::vector<std::string> errors(names.size());
+	std::atomic<int> next(0);
+	std::atomic<int> done(0);
+	std::mutex report_mutex;
+
+	FILE *metrics_output = NULL; // JSON lines, one per image
+	if (!param_metrics_output_name->empty()) {
+		metrics_output = fopen(param_metrics_output_name->c_str(), "w");
+		if (!metrics_output)
+			log.log<log_level::error>("Batch: unable to write metrics to \"%s\"\n", param_metrics_output_name->c_str());
+	}
+
+	auto report = [&](int i, const metrics &met) {
+		std::lock_guard<std::mutex> lock(report_mutex); // Report each image as soon as it is finished
+		if (metrics_output && errors[i].empty())
+			met.write_json(metrics_output, names[i]);
+		int count = ++done;
+		if (errors[i].empty())
+			log.log<log_level::info>("Batch [%i/%i] %s: %fs\n", count, names.size(), names[i].c_str(), times[i]);
+		else
+			log.log<log_level::error>("Batch [%i/%i] %s: failed: %s\n", count, names.size(), names[i].c_str(), errors[i].c_str());
+	};
+
+	timer batch_timer(0);
+	batch_timer.start();
+	if (*param_batch_pipeline && pipeline::supported(snapshot)) {
+		log.log<log_level::info>("Batch: using pipeline, queue size %i\n", *param_batch_queue_size);
+		pipeline pipe(snapshot, workers, *param_batch_queue_size);
+		pipe.run(names, [&](pipeline_frame &f) { // Export stage, frames come in input order
+			errors[f.index] = f.error;
+			if (f.error.empty()) {
+				try {
+					save(f.j, f.name);
+				}
+				catch (const std::exception &e) {
+					errors[f.index] = e.what();
+				}
+			}
+			times[f.index] = f.time;
+			report(f.index, f.j.met);
+		});
+	}
+	else {
+		if (*param_batch_pipeline)
+			log.log<log_level::warning>("Batch: pipeline supports only custom vectorizer without tiling, caching and streaming input, using workers\n");
+		auto worker = [&]() {
+			int i;
+			while ((i = next++) < (int) names.size()) {
+				metrics met;
+				process(snapshot, names[i], times[i], errors[i], met);
+				report(i, met);
+			}
+		};
+		std::vector<std::thread> threads;
+		for (int t = 0; t < workers; t++)
+			threads.emplace_back(worker);
+		for (auto &t: threads)
+			t.join();
+	}
+	batch_timer.stop();
+	if (metrics_output)
+		fclose(metrics_output);
+
+	int failed = std::count_if(errors.begin(), errors.end(), [](const std::string &e) { return !e.empty(); });
+	log.log<log_level::info>("Batch: %i images vectorized, %i failed, total time: %fs\n", names.size() - failed, failed, batch_timer.read());
+	return failed;
+}
+
+}; // namespace
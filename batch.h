@@ -0,0 +1,60 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__BATCH_H
+#define VECTORIX__BATCH_H
+
+// Batch mode: vectorize many images in one process
+
+#include <string>
+#include <vector>
+#include "job.h"
+#include "parameters.h"
+#include "metrics.h"
+#include "logger.h"
+
+namespace vectorix {
+
+class batch {
+public:
+	batch(parameters &params): par(&params) {
+		int *param_batch_verbosity;
+		par->bind_param(param_batch_verbosity, "batch_verbosity", (int) log_level::info);
+		log.set_verbosity((log_level) *param_batch_verbosity);
+
+		par->add_comment("Batch mode: list file (one image per line) or directory with input images, empty = single image mode");
+		par->bind_param(param_batch_input, "batch_input", (std::string) "");
+		par->add_comment("Directory for vector outputs of batch mode: empty = next to input images");
+		par->bind_param(param_batch_output, "batch_output", (std::string) "");
+		par->add_comment("Count of images vectorized at once: 0 = number of cores");
+		par->bind_param(param_batch_workers, "batch_workers", 0);
+		par->add_comment("Pipeline: 0: each worker vectorizes whole image, 1: stages run in own threads connected by queues (custom vectorizer only)");
+		par->bind_param(param_batch_pipeline, "batch_pipeline", 0);
+		par->add_comment("Capacity of queues between pipeline stages");
+		par->bind_param(param_batch_queue_size, "batch_queue_size", 4);
+		par->add_comment("Save stage times and work counters as JSON (file or /dev/fd/N): empty = no output");
+		par->bind_param(param_metrics_output_name, "file_metrics", (std::string) "");
+	};
+	bool enabled() const { return !param_batch_input->empty(); };
+	int run(); // Vectorize all images, returns count of failed ones
+private:
+	std::string *param_batch_input;
+	std::string *param_batch_output;
+	int *param_batch_workers;
+	int *param_batch_pipeline;
+	int *param_batch_queue_size;
+	std::string *param_metrics_output_name;
+
+	void list_inputs(std::vector<std::string> &names); // Read list file or directory
+	std::string output_name(const std::string &input_name, int output_engine); // Where to save vector output
+	void process(const parameters &snapshot, const std::string &name, double &time, std::string &error, metrics &met); // Vectorize one image
+	void save(job &j, const std::string &name); // Write vector output of finished job
+
+	logger log;
+	parameters *par;
+};
+
+}; // namespace
+
+#endif
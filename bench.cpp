@@ -0,0 +1,315 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+
+// Micro-benchmarks of geometry, fitting, tracing and pixel kernels
+//
+// Usage: ./vectorix_bench [name filter] [iteration multiplier]
+// Inputs are generated from fixed seeds, results are comparable between runs.
+// Every operation gets its own prepared copy of input, copying is not measured.
+
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+#include <functional>
+#include "v_image.h"
+#include "geom.h"
+#include "parameters.h"
+#include "approximation.h"
+#include "offset.h"
+#include "tracer.h"
+#include "tracer_helper.h"
+#include "timer.h"
+#include "pnm_kernels.h"
+
+using namespace vectorix;
+
+/*
+ * Allocation counting
+ */
+
+static std::atomic<long> allocations(0);
+
+void *operator new(size_t size) {
+	allocations++;
+	if (void *ptr = malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+/*
+ * Harness
+ */
+
+static const char *filter = "";
+static int multiplier = 1;
+
+// Run func(i) for i in [0, iterations), prepare(iterations) is called before and not measured
+static void bench(const char *name, int iterations, std::function<void(int)> prepare, std::function<void(int)> func) {
+	if (!strstr(name, filter))
+		return;
+	iterations *= multiplier;
+	prepare(iterations);
+	for (int i = 0; i < iterations / 10; i++) // Warm up caches and allocator
+		func(i);
+	prepare(iterations);
+
+	long allocations_before = allocations;
+	timer t(0);
+	t.start();
+	for (int i = 0; i < iterations; i++)
+		func(i);
+	t.stop();
+	long allocated = allocations - allocations_before;
+
+	printf("%-48s %12.1f ns/op %10.2f allocs/op\n", name, t.read() * 1e9 / iterations, (double) allocated / iterations);
+	fflush(stdout);
+}
+
+static v_pt random_pt(std::mt19937 &rng, p size) {
+	std::uniform_real_distribution<p> d(0, size);
+	return v_pt(d(rng), d(rng));
+}
+
+static v_point random_point(std::mt19937 &rng, p size) {
+	v_point pt(random_pt(rng, size), random_pt(rng, size), random_pt(rng, size));
+	pt.width = 1 + std::uniform_real_distribution<p>(0, 4)(rng);
+	return pt;
+}
+
+static v_line random_line(std::mt19937 &rng, int points, p size) { // Smooth line with variable width
+	v_line line;
+	v_pt pos = random_pt(rng, size);
+	std::uniform_real_distribution<p> step(-size / 8, size / 8);
+	for (int i = 0; i < points; i++) {
+		v_pt next = pos + v_pt(step(rng), step(rng));
+		line.add_point(pos - (next - pos) / 3, pos, pos + (next - pos) / 3, v_co(0, 0, 0), 1 + std::uniform_real_distribution<p>(0, 4)(rng));
+		pos = next;
+	}
+	return line;
+}
+
+/*
+ * Tracer kernels (private)
+ */
+
+namespace vectorix {
+
+class tracer_bench {
+public:
+	tracer_bench(parameters &params): tra(params) {
+		// Synthetic skeleton: random strokes, distance from edge 3
+		std::mt19937 rng(7);
+		cv::Mat skeleton = cv::Mat::zeros(512, 512, CV_8UC1);
+		for (int i = 0; i < 64; i++) {
+			v_pt a = random_pt(rng, 512);
+			v_pt b = random_pt(rng, 512);
+			cv::line(skeleton, cv::Point(a.x, a.y), cv::Point(b.x, b.y), cv::Scalar(3));
+		}
+		cv::Mat distance;
+		skeleton.convertTo(distance, CV_32SC1);
+		tra.lab_skel = labeled_Mat(params);
+		tra.lab_skel.init(skeleton);
+		tra.color = cv::Mat::zeros(512, 512, CV_8UC3);
+		tra.dist = distance;
+
+		for (int i = 0; i < 1024; i++) { // Query points near strokes
+			cv::Point pt;
+			do {
+				pt = cv::Point(rng() % 512, rng() % 512);
+			} while (!skeleton.at<uint8_t>(pt.y, pt.x) && (rng() % 16));
+			centers.push_back(v_pt(pt.x + 0.5, pt.y + 0.5));
+			ends.push_back(centers.back() + geom::rotate(v_pt(*tra.param_nearby_limit, 0), (rng() % 628) / 100.));
+		}
+	};
+	p line_fitness(int i) {
+		int k = i % centers.size();
+		return tra.calculate_line_fitness(centers[k], ends[k], 0, *tra.param_nearby_limit);
+	};
+	v_pt best_gaussian(int i) {
+		return tra.find_best_gaussian(centers[i % centers.size()], 2);
+	};
+private:
+	tracer tra;
+	std::vector<v_pt> centers;
+	std::vector<v_pt> ends;
+};
+
+}; // namespace
+
+/*
+ * Benchmarks
+ */
+
+int main(int argc, char **argv) {
+	if (argc > 1)
+		filter = argv[1];
+	if (argc > 2)
+		multiplier = std::max(1, atoi(argv[2]));
+
+	parameters par;
+	volatile p sink = 0; // Keep results alive
+
+	// Geometry
+	{
+		std::mt19937 rng(1);
+		std::vector<v_point> base;
+		for (int i = 0; i < 2048; i++)
+			base.push_back(random_point(rng, 100));
+		std::vector<v_point> pts;
+		v_point middle;
+		bench("geom::bezier_chop_in_t", 2000000, [&](int n) {
+			pts.clear();
+			for (int i = 0; i < n + 1; i++)
+				pts.push_back(base[i % base.size()]);
+		}, [&](int i) {
+			geom::bezier_chop_in_t(pts[i], pts[i + 1], middle, 0.3);
+			sink += middle.main.x;
+		});
+
+		std::vector<v_point> a, b;
+		for (int i = 0; i < 1024; i++) {
+			a.push_back(random_point(rng, 100));
+			b.push_back(random_point(rng, 100));
+		}
+		bench("geom::bezier_intersection", 200000, [&](int) {}, [&](int i) {
+			p t1, t2;
+			int k = i % 1023;
+			sink += geom::bezier_intersection(a[k], a[k + 1], b[k], b[k + 1], t1, t2);
+		});
+
+		v_line line = random_line(rng, 32, 100);
+		std::vector<v_line> lines;
+		bench("geom::chop_line", 2000, [&](int n) {
+			lines.assign(n, line);
+		}, [&](int i) {
+			geom::chop_line(lines[i], 1);
+			sink += lines[i].segment.size();
+		});
+	}
+
+	// Approximation
+	for (int method = 0; method < 2; method++) {
+		parameters apx_par(par);
+		int *lsq_method;
+		apx_par.bind_param(lsq_method, "lsq_method", 0);
+		*lsq_method = method;
+		approximation apx(apx_par);
+
+		std::mt19937 rng(2);
+		class sample {
+		public:
+			std::vector<v_pt> points;
+			std::vector<p> times;
+			v_point a, b;
+		};
+		std::vector<sample> samples;
+		for (int s = 0; s < 256; s++) { // Noisy points on random Bezier segment
+			sample smp;
+			smp.a = random_point(rng, 100);
+			smp.b = random_point(rng, 100);
+			std::normal_distribution<p> noise(0, 0.3);
+			for (int i = 1; i < 16; i++) {
+				v_point one = smp.a, two = smp.b, mid;
+				geom::bezier_chop_in_t(one, two, mid, i / 16., true);
+				smp.points.push_back(mid.main + v_pt(noise(rng), noise(rng)));
+				smp.times.push_back(i / 16.);
+			}
+			samples.push_back(smp);
+		}
+		std::vector<sample> work;
+		bench(method ? "approximation::optimize (least_squares_simple)" : "approximation::optimize (least_squares_opencv)", 20000, [&](int n) {
+			work.clear();
+			for (int i = 0; i < n; i++)
+				work.push_back(samples[i % samples.size()]);
+		}, [&](int i) {
+			sample &s = work[i];
+			sink += apx.optimize_control_point_lengths(s.points, s.times, s.a.main, s.a.control_next, s.b.control_prev, s.b.main);
+		});
+	}
+
+	// Tracing
+	{
+		parameters tra_par(par);
+		tracer_bench tb(tra_par);
+		bench("tracer::calculate_line_fitness", 200000, [&](int) {}, [&](int i) {
+			sink += tb.line_fitness(i);
+		});
+		bench("tracer::find_best_gaussian", 20000, [&](int) {}, [&](int i) {
+			sink += tb.best_gaussian(i).x;
+		});
+	}
+
+	// Offset
+	{
+		std::mt19937 rng(3);
+		v_image img(100, 100);
+		offset off(img, par);
+		std::vector<v_line> base;
+		for (int i = 0; i < 16; i++)
+			base.push_back(random_line(rng, 8, 100));
+		std::vector<v_line> lines;
+		bench("offset::convert_to_outline", 2000, [&](int n) {
+			lines.clear();
+			for (int i = 0; i < n; i++)
+				lines.push_back(base[i % base.size()]);
+		}, [&](int i) {
+			off.convert_to_outline(lines[i]);
+			sink += lines[i].segment.size();
+		});
+	}
+	// PNM pixel kernels, every SIMD level supported by CPU (one op = one 4096 pixel row)
+	{
+		std::mt19937 rng(4);
+		const int width = 4096;
+		std::vector<uint8_t> gray(width), rgb(width * 3), bits(width / 8), out(width * 3);
+		for (uint8_t &v: gray)
+			v = rng();
+		for (uint8_t &v: rgb)
+			v = rng();
+		for (uint8_t &v: bits)
+			v = rng();
+		for (int l = 0; l <= (int) pnm_kernels::detected_level(); l++) {
+			pnm_kernels::simd_level level = (pnm_kernels::simd_level) l;
+			pnm_kernels::set_level(level);
+			std::string suffix = std::string(" (") + pnm_kernels::level_name(level) + ")";
+			bench(("pnm_kernels::unpack_bits" + suffix).c_str(), 200000, [&](int) {}, [&](int) {
+				pnm_kernels::unpack_bits(bits.data(), out.data(), width, 0, 255);
+				sink += out[width - 1];
+			});
+			bench(("pnm_kernels::pack_bits" + suffix).c_str(), 200000, [&](int) {}, [&](int) {
+				pnm_kernels::pack_bits(gray.data(), out.data(), width, 127);
+				sink += out[width / 8 - 1];
+			});
+			bench(("pnm_kernels::pack_rgb_bits" + suffix).c_str(), 50000, [&](int) {}, [&](int) {
+				pnm_kernels::pack_rgb_bits(rgb.data(), out.data(), width, 382);
+				sink += out[width / 8 - 1];
+			});
+			bench(("pnm_kernels::rgb_to_gray" + suffix).c_str(), 50000, [&](int) {}, [&](int) {
+				pnm_kernels::rgb_to_gray(rgb.data(), out.data(), width);
+				sink += out[width - 1];
+			});
+			bench(("pnm_kernels::gray_to_rgb" + suffix).c_str(), 50000, [&](int) {}, [&](int) {
+				pnm_kernels::gray_to_rgb(gray.data(), out.data(), width);
+				sink += out[width * 3 - 1];
+			});
+		}
+		pnm_kernels::set_level(pnm_kernels::detected_level());
+	}
+	return 0;
+}
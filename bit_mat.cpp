@@ -0,0 +1,63 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+#include "bit_mat.h"
+
+using namespace cv;
+
+namespace vectorix {
+
+void bit_mat::create(int rows_, int cols_) {
+	rows = rows_;
+	cols = cols_;
+	stride = (cols + 63) / 64 + 1; // Spare word after last pixel
+	data.assign((size_t) rows * stride, 0);
+}
+
+void bit_mat::from_mat(const Mat &image, int border) {
+	create(image.rows + 2*border, image.cols + 2*border);
+	for (int i = 0; i < image.rows; i++) {
+		const uint8_t *in = image.ptr<uint8_t>(i);
+		uint64_t *out = row(i + border);
+		for (int j = 0; j < image.cols; j += 64) {
+			uint64_t word = 0;
+			int n = std::min(64, image.cols - j);
+			for (int k = 0; k < n; k++)
+				word |= (uint64_t) !!in[j + k] << k;
+			int pos = j + border; // Word covers pixels pos .. pos + 63
+			out[pos >> 6] |= word << (pos & 63);
+			if ((pos & 63) && ((pos >> 6) + 1 < stride))
+				out[(pos >> 6) + 1] |= word >> (64 - (pos & 63));
+		}
+	}
+}
+
+void bit_mat::to_mat(Mat &image) const {
+	image.create(rows, cols, CV_8UC(1));
+	for (int i = 0; i < rows; i++) {
+		const uint64_t *in = row(i);
+		uint8_t *out = image.ptr<uint8_t>(i);
+		for (int j = 0; j < cols; j++)
+			out[j] = ((in[j >> 6] >> (j & 63)) & 1) ? 255 : 0;
+	}
+}
+
+void bit_mat::copy_with_border(bit_mat &out, int border) const {
+	out.create(rows + 2*border, cols + 2*border);
+	int words = (cols + 63) / 64; // Words with pixels
+	for (int i = 0; i < rows; i++) {
+		const uint64_t *in = row(i);
+		uint64_t *o = out.row(i + border);
+		for (int w = 0; w < words; w++) {
+			o[w] |= in[w] << border;
+			if (border && (w + 1 < out.stride))
+				o[w + 1] |= in[w] >> (64 - border);
+		}
+	}
+}
+
+}; // namespace
@@ -0,0 +1,64 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__BIT_MAT_H
+#define VECTORIX__BIT_MAT_H
+
+// Binary image with one bit per pixel
+//
+// Pixel j of row is bit j % 64 of word j / 64 (first pixel in lowest bit).
+// Every row has at least one extra zero word at the end, so neighbours of
+// the last pixel can be read without checks. Unused bits are always zero.
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace vectorix {
+
+class bit_mat {
+public:
+	bit_mat(): rows(0), cols(0), stride(0) {};
+	bit_mat(int rows_, int cols_) { create(rows_, cols_); };
+	void create(int rows_, int cols_); // All pixels are unset
+	bool empty() const { return data.empty(); };
+
+	bool get(int i, int j) const { return (data[i*stride + (j >> 6)] >> (j & 63)) & 1; };
+	void set(int i, int j) { data[i*stride + (j >> 6)] |= (uint64_t) 1 << (j & 63); };
+	void clear(int i, int j) { data[i*stride + (j >> 6)] &= ~((uint64_t) 1 << (j & 63)); };
+	uint64_t *row(int i) { return &data[i*stride]; };
+	const uint64_t *row(int i) const { return &data[i*stride]; };
+
+	// Count of set neighbours, pixel must not lie on image border
+	int sum_8_connected(int i, int j) const {
+		return __builtin_popcountll(triple(row(i - 1), j)) + __builtin_popcountll(triple(row(i + 1), j)) + __builtin_popcountll(triple(row(i), j) & 5);
+	};
+	int sum_4_connected(int i, int j) const {
+		return ((triple(row(i - 1), j) >> 1) & 1) + ((triple(row(i + 1), j) >> 1) & 1) + __builtin_popcountll(triple(row(i), j) & 5);
+	};
+
+	void from_mat(const cv::Mat &image, int border = 0); // Non-zero pixels of 8bit image are set, add border of unset pixels
+	void to_mat(cv::Mat &image) const; // 8bit image, set pixels are 255
+	void copy_with_border(bit_mat &out, int border) const; // Copy with border of unset pixels (less than 64 px)
+
+	size_t total() const { return data.size(); }; // Words of data (for count_mat)
+	size_t elemSize() const { return sizeof(uint64_t); };
+
+	int rows;
+	int cols;
+	int stride; // Words per row
+private:
+	static uint64_t triple(const uint64_t *r, int j) { // Pixels j - 1, j, j + 1 in lowest three bits
+		int s = j - 1;
+		uint64_t v = r[s >> 6] >> (s & 63);
+		if ((s & 63) > 61)
+			v |= r[(s >> 6) + 1] << (64 - (s & 63));
+		return v & 7;
+	};
+	std::vector<uint64_t> data;
+};
+
+}; // namespace
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__BOUNDED_QUEUE_H
+#define VECTORIX__BOUNDED_QUEUE_H
+
+// Thread-safe FIFO with limited capacity
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+namespace vectorix {
+
+template <typename T>
+class bounded_queue {
+public:
+	bounded_queue(size_t capacity): capacity_(capacity ? capacity : 1) {};
+
+	bool push(T item) { // Wait for free space, returns false if queue was closed
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_full_.wait(lock, [&]() { return closed_ || (items_.size() < capacity_); });
+		if (closed_)
+			return false;
+		items_.push_back(std::move(item));
+		not_empty_.notify_one();
+		return true;
+	};
+
+	bool try_push(T &item) { // Do not wait, returns false if queue is full or closed (item is kept)
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (closed_ || (items_.size() >= capacity_))
+			return false;
+		items_.push_back(std::move(item));
+		not_empty_.notify_one();
+		return true;
+	};
+
+	bool pop(T &item) { // Wait for item, returns false if queue is closed and empty
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_empty_.wait(lock, [&]() { return closed_ || !items_.empty(); });
+		if (items_.empty())
+			return false;
+		item = std::move(items_.front());
+		items_.pop_front();
+		not_full_.notify_one();
+		return true;
+	};
+
+	void close() { // No more items will be pushed, waiting threads are woken up
+		std::lock_guard<std::mutex> lock(mutex_);
+		closed_ = true;
+		not_empty_.notify_all();
+		not_full_.notify_all();
+	};
+
+private:
+	size_t capacity_;
+	bool closed_ = false;
+	std::deque<T> items_;
+	std::mutex mutex_;
+	std::condition_variable not_empty_;
+	std::condition_variable not_full_;
+};
+
+}; // namespace
+
+#endif
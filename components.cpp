@@ -0,0 +1,200 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include "components.h"
+#include "parallel.h"
+
+// Connected components of binary images
+
+using namespace cv;
+
+namespace vectorix {
+namespace components {
+
+static int find(std::vector<int> &parent, int x) { // Union-find root with path halving
+	while (parent[x] != x) {
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+static void join(std::vector<int> &parent, int a, int b) { // Smaller root wins, keeps raster order
+	a = find(parent, a);
+	b = find(parent, b);
+	if (a < b)
+		parent[b] = a;
+	else if (b < a)
+		parent[a] = b;
+}
+
+int label(const Mat &image, Mat &labels, std::vector<component> &list, int threads, bool background) {
+	labels = Mat::zeros(image.rows, image.cols, CV_32SC1);
+	threads = std::max(1, std::min(threads, image.rows));
+	int band_rows = (image.rows + threads - 1) / std::max(1, threads);
+	int bands = band_rows ? (image.rows + band_rows - 1) / band_rows : 0;
+	auto is_set = [&](const uint8_t *row, int j) {
+		return background ? !row[j] : !!row[j];
+	};
+
+	// First pass: provisional labels in every band, remember equivalences
+	std::vector<std::vector<int>> band_parent(bands);
+	parallel_for(bands, threads, [&](int b, int) {
+		std::vector<int> &parent = band_parent[b];
+		parent.assign(1, 0);
+		int first = b * band_rows;
+		int last = std::min(image.rows, first + band_rows);
+		for (int i = first; i < last; i++) {
+			const uint8_t *row = image.ptr<uint8_t>(i);
+			int32_t *lab = labels.ptr<int32_t>(i);
+			int32_t *prev = (i > first) ? labels.ptr<int32_t>(i - 1) : NULL;
+			for (int j = 0; j < image.cols; j++) {
+				if (!is_set(row, j))
+					continue;
+				int l = 0;
+				auto neighbour = [&](int n) {
+					if (!n)
+						return;
+					if (!l)
+						l = n;
+					else
+						join(parent, l, n);
+				};
+				if (j)
+					neighbour(lab[j - 1]);
+				if (prev) {
+					if (j && !background)
+						neighbour(prev[j - 1]);
+					neighbour(prev[j]);
+					if ((j + 1 < image.cols) && !background)
+						neighbour(prev[j + 1]);
+				}
+				if (!l) { // New component
+					l = parent.size();
+					parent.push_back(l);
+				}
+				lab[j] = l;
+			}
+		}
+	});
+
+	// Labels of band b are shifted by base[b], earlier bands have smaller labels (raster order is kept)
+	std::vector<int> base(bands + 1, 0);
+	for (int b = 0; b < bands; b++)
+		base[b + 1] = base[b] + band_parent[b].size() - 1;
+	std::vector<int> parent(base[bands] + 1, 0);
+	for (int b = 0; b < bands; b++) {
+		for (int l = 1; l < (int) band_parent[b].size(); l++)
+			parent[base[b] + l] = base[b] + band_parent[b][l];
+	}
+	for (int b = 1; b < bands; b++) { // Join components across seams
+		int i = b * band_rows;
+		const int32_t *lab = labels.ptr<int32_t>(i);
+		const int32_t *prev = labels.ptr<int32_t>(i - 1);
+		for (int j = 0; j < image.cols; j++) {
+			if (!lab[j])
+				continue;
+			for (int k = background ? j : j - 1; k <= (background ? j : j + 1); k++) {
+				if ((k >= 0) && (k < image.cols) && prev[k])
+					join(parent, base[b] + lab[j], base[b - 1] + prev[k]);
+			}
+		}
+	}
+
+	// Final labels: roots numbered in order of appearance
+	std::vector<int> final_label(parent.size(), 0);
+	int count = 0;
+	for (int l = 1; l < (int) parent.size(); l++) {
+		int root = find(parent, l);
+		if (root == l)
+			final_label[l] = ++count;
+		else
+			final_label[l] = final_label[root]; // Root is always smaller
+	}
+
+	// Second pass: relabel and measure (by provisional labels of band, merged afterwards)
+	class box {
+	public:
+		int pixels = 0;
+		int min_x = INT_MAX, min_y = INT_MAX, max_x = -1, max_y = -1;
+		void add(const box &b) {
+			pixels += b.pixels;
+			min_x = std::min(min_x, b.min_x);
+			max_x = std::max(max_x, b.max_x);
+			min_y = std::min(min_y, b.min_y);
+			max_y = std::max(max_y, b.max_y);
+		};
+	};
+	std::vector<std::vector<box>> band_box(bands);
+	parallel_for(bands, threads, [&](int b, int) {
+		std::vector<box> &bx = band_box[b];
+		bx.resize(band_parent[b].size());
+		for (int i = b * band_rows; i < std::min(image.rows, (b + 1) * band_rows); i++) {
+			int32_t *lab = labels.ptr<int32_t>(i);
+			for (int j = 0; j < image.cols; j++) {
+				if (!lab[j])
+					continue;
+				box &x = bx[lab[j]];
+				lab[j] = final_label[base[b] + lab[j]];
+				x.pixels++;
+				x.min_x = std::min(x.min_x, j);
+				x.max_x = std::max(x.max_x, j);
+				x.min_y = std::min(x.min_y, i);
+				x.max_y = std::max(x.max_y, i);
+			}
+		}
+	});
+	list.assign(count, component());
+	std::vector<box> boxes(count);
+	for (int b = 0; b < bands; b++) {
+		for (int l = 1; l < (int) band_box[b].size(); l++)
+			boxes[final_label[base[b] + l] - 1].add(band_box[b][l]);
+	}
+	for (int c = 0; c < count; c++) {
+		list[c].pixels = boxes[c].pixels;
+		list[c].bbox = Rect(boxes[c].min_x, boxes[c].min_y, boxes[c].max_x - boxes[c].min_x + 1, boxes[c].max_y - boxes[c].min_y + 1);
+	}
+	return count;
+}
+
+int group(const std::vector<component> &list, int margin, std::vector<int> &group_of) {
+	int count = list.size();
+	std::vector<int> parent(count);
+	for (int c = 0; c < count; c++)
+		parent[c] = c;
+
+	// Sweep by x: compare only boxes with overlapping extended x ranges
+	std::vector<int> order(count);
+	for (int c = 0; c < count; c++)
+		order[c] = c;
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return list[a].bbox.x < list[b].bbox.x; });
+	for (int a = 0; a < count; a++) {
+		const Rect &ra = list[order[a]].bbox;
+		for (int b = a + 1; b < count; b++) {
+			const Rect &rb = list[order[b]].bbox;
+			if (rb.x - margin >= ra.x + ra.width + margin)
+				break; // All following boxes start even further
+			if ((rb.y - margin < ra.y + ra.height + margin) && (ra.y - margin < rb.y + rb.height + margin))
+				join(parent, order[a], order[b]);
+		}
+	}
+
+	group_of.assign(count, 0);
+	std::vector<int> group_index(count, -1);
+	int groups = 0;
+	for (int c = 0; c < count; c++) {
+		int root = find(parent, c);
+		if (group_index[root] < 0)
+			group_index[root] = groups++;
+		group_of[c] = group_index[root];
+	}
+	return groups;
+}
+
+}; // namespace
+}; // namespace
@@ -0,0 +1,35 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__COMPONENTS_H
+#define VECTORIX__COMPONENTS_H
+
+// Connected components of binary (8bit) images
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+namespace vectorix {
+
+class component {
+public:
+	cv::Rect bbox; // Bounding box
+	int pixels = 0; // Count of pixels
+};
+
+namespace components {
+	// Label 8-connected non-zero pixels of 8bit image, labels (CV_32S) are numbered
+	// from 1 in raster order of first pixels, 0 = background. Returns count of components,
+	// list[i] describes component with label i + 1.
+	// Bands of rows are labeled by given count of threads and joined, result does not depend on it.
+	// With background set, 4-connected zero pixels are labeled instead.
+	int label(const cv::Mat &image, cv::Mat &labels, std::vector<component> &list, int threads = 1, bool background = false);
+	// Put components whose bounding boxes extended by margin overlap into one group,
+	// groups are numbered in order of their first component. Returns count of groups.
+	int group(const std::vector<component> &list, int margin, std::vector<int> &group_of);
+};
+
+}; // namespace
+
+#endif
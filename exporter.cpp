@@ -3,6 +3,8 @@
  * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
  */
 #include <cstdio>
+#include <cstdarg>
+#include <string>
 #include <locale>
 #include "v_image.h"
 #include "exporter.h"
@@ -13,8 +15,42 @@ namespace vectorix {
 
 void exporter::write(FILE *fd_, const v_image &image_) {
 	fd = fd_;
+	out = NULL;
 	image = &image_;
+	write_image();
+}
+
+void exporter::write(std::string &out_, const v_image &image_) {
+	fd = NULL;
+	out = &out_;
+	image = &image_;
+	write_image();
+}
+
+void exporter::print(const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	if (fd)
+		vfprintf(fd, format, args);
+	else {
+		char buffer[256];
+		va_list copy;
+		va_copy(copy, args);
+		int len = vsnprintf(buffer, sizeof(buffer), format, copy);
+		va_end(copy);
+		if (len < (int) sizeof(buffer))
+			out->append(buffer, len);
+		else { // Long line, print again with exact size
+			size_t pos = out->size();
+			out->resize(pos + len + 1);
+			vsnprintf(&(*out)[pos], len + 1, format, args);
+			out->resize(pos + len);
+		}
+	}
+	va_end(args);
+}
 
+void exporter::write_image() {
 	std::locale("C"); // Set locale for printing flaoting-point
 	write_header();
 	for (const v_line &line: image->line) {
@@ -6,6 +6,7 @@
 #define VECTORIX__EXPORTER_H
 
 #include <cstdio>
+#include <string>
 #include "v_image.h"
 
 // Generic exporter
@@ -15,13 +16,17 @@ namespace vectorix {
 class exporter {
 public:
 	void write(FILE *fd_, const v_image &image_); // Write image to open filedescriptor
+	void write(std::string &out_, const v_image &image_); // Append image to string
 private:
 	virtual void write_header() = 0;
 	virtual void write_line(const v_line &line) = 0;
 	virtual void write_footer() = 0;
+	void write_image(); // Header, lines and footer
 protected:
 	exporter() = default;
+	void print(const char *format, ...); // printf to output (file or string)
 	FILE *fd;
+	std::string *out;
 	v_image const *image;
 };
 
@@ -0,0 +1,173 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdio>
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include "job.h"
+#include "pnm_handler.h"
+#include "v_image.h"
+#include "parameters.h"
+#include "vectorizer.h"
+#include "vectorizer_potrace.h"
+#include "vectorizer_vectorix.h"
+#include "exporter_svg.h"
+#include "exporter_ps.h"
+#include "finisher.h"
+#include "timer.h"
+#include "metrics.h"
+#include "stream_decoder.h"
+
+// One vectorization job: private copy of parameters, input image and vector output
+
+namespace vectorix {
+
+static bool is_pnm_name(const std::string &filename) { // Guess file format by its extension
+	size_t dot = filename.rfind('.');
+	if (dot == std::string::npos)
+		return false;
+	std::string ext = filename.substr(dot + 1);
+	return ext == "pnm" || ext == "pbm" || ext == "pgm" || ext == "ppm";
+}
+
+void job::load(const std::string &filename) {
+	metrics_scope scope(&met);
+	stage_timer time("decode");
+	if ((*param_vectorization_method == 0) && !is_pnm_name(filename)) {
+		*param_custom_input_name = filename; // Custom vectorizer will load it by OpenCV
+		return;
+	}
+	param_custom_input_name->clear();
+	stream_name.clear();
+	stream_decoder dec(par);
+	if ((*param_vectorization_method == 0) && dec.enabled() && dec.supported(filename)) {
+		stream_name = filename; // Read in vectorize()
+		return;
+	}
+	FILE *fd = fopen(filename.c_str(), "r");
+	if (!fd)
+		throw std::invalid_argument("Unable to open input image.");
+	try {
+		input.read(fd);
+	}
+	catch (...) {
+		fclose(fd);
+		throw;
+	}
+	fclose(fd);
+}
+
+void job::load(FILE *fd) {
+	metrics_scope scope(&met);
+	stage_timer time("decode");
+	param_custom_input_name->clear();
+	stream_name.clear();
+	input.read(fd);
+}
+
+void job::load(const void *buffer, size_t length) {
+	metrics_scope scope(&met);
+	stage_timer time("decode");
+	param_custom_input_name->clear();
+	stream_name.clear();
+	input.map(buffer, length);
+}
+
+void job::load(const uint8_t *pixels, int width, int height, int channels, size_t stride) {
+	if ((width <= 0) || (height <= 0) || ((channels != 1) && (channels != 3) && (channels != 4)))
+		throw std::invalid_argument("Unsupported pixel buffer.");
+	param_custom_input_name->clear();
+	stream_name.clear();
+	input = pnm_image(width, height, pnm_variant_type::binary_ppm, par);
+	for (int j = 0; j < height; j++) {
+		const uint8_t *row = pixels + j * stride;
+		pnm_data_t *out = input.data + (size_t) j * width * 3;
+		for (int i = 0; i < width; i++) {
+			const uint8_t *px = row + i * channels;
+			out[i*3 + 0] = px[0];
+			out[i*3 + 1] = px[(channels >= 3) ? 1 : 0];
+			out[i*3 + 2] = px[(channels >= 3) ? 2 : 0];
+		}
+	}
+}
+
+void job::vectorize() {
+	if (!stream_name.empty()) { // Custom vectorizer reads the file itself
+		FILE *fd = fopen(stream_name.c_str(), "r");
+		if (!fd)
+			throw std::invalid_argument("Unable to open input image.");
+		vectorizer_vectorix ve(par);
+		metrics_scope scope(&met);
+		timer vectorization_timer(0);
+		vectorization_timer.start();
+		try {
+			output = ve.vectorize_stream(fd);
+		}
+		catch (...) {
+			fclose(fd);
+			throw;
+		}
+		vectorization_timer.stop();
+		fclose(fd);
+		vectorization_time = vectorization_timer.read();
+		met.add_time("vectorization", vectorization_time);
+		return;
+	}
+	if (input.type != pnm_variant_type::binary_pbm) // Bitmaps are handled by vectorizers (without expanding to RGB)
+		input.convert(pnm_variant_type::binary_ppm);
+	std::unique_ptr<vectorizer> ve;
+	switch (*param_vectorization_method) {
+		case 0: // Custom center-line based vectorizer
+			ve = std::unique_ptr<vectorizer>(new vectorizer_vectorix(par));
+			break;
+		case 1: // Use potracelib
+			ve = std::unique_ptr<vectorizer>(new vectorizer_potrace(par));
+			break;
+		case 2: // Stupid - just output simple line; frankly, it ignores input image
+			ve = std::unique_ptr<vectorizer>(new vectorizer_example(par));
+			break;
+		default:
+			throw std::invalid_argument("Unknown vectorization method.");
+	}
+	metrics_scope scope(&met);
+	timer vectorization_timer(0);
+	vectorization_timer.start();
+	output = ve->vectorize(input);
+	vectorization_timer.stop();
+	vectorization_time = vectorization_timer.read();
+	met.add_time("vectorization", vectorization_time);
+}
+
+void job::finish() {
+	finisher fin(par); // Pre-export changes & transformations
+	fin.apply_settings(output);
+	met.add_output(output);
+}
+
+void job::write(std::string &out) {
+	finish();
+	if (*param_output_engine == 0) {
+		exporter_svg ex;
+		ex.write(out, output); // Write svg
+	}
+	else {
+		exporter_ps ex;
+		ex.write(out, output); // Write postscript
+	}
+}
+
+void job::write(FILE *fd) {
+	finish();
+	if (*param_output_engine == 0) {
+		exporter_svg ex;
+		ex.write(fd, output); // Write svg
+	}
+	else {
+		exporter_ps ex;
+		ex.write(fd, output); // Write postscript
+	}
+}
+
+}; // namespace
@@ -0,0 +1,55 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__JOB_H
+#define VECTORIX__JOB_H
+
+// One vectorization job: private copy of parameters, input image and vector output
+
+#include <cstdio>
+#include <string>
+#include <cstdint>
+#include "pnm_handler.h"
+#include "v_image.h"
+#include "parameters.h"
+#include "metrics.h"
+
+namespace vectorix {
+
+class job {
+public:
+	job(const parameters &params): par(params), input(par) { // Parameters are copied, job can run in its own thread
+		par.bind_param(param_vectorization_method, "vectorization_method", 0);
+		par.bind_param(param_output_engine, "output_engine", 0);
+		par.bind_param(param_custom_input_name, "file_input", (std::string) "");
+
+		int *param_interactive;
+		par.bind_param(param_interactive, "interactive", 1);
+		*param_interactive = 0; // Jobs never open windows
+	};
+	void load(const std::string &filename); // Load input image (PNM by own reader, other formats by OpenCV)
+	void load(FILE *fd); // PNM image from open stream, stream is left at first byte after the image
+	void load(const void *buffer, size_t length); // PNM image in memory, binary images are not copied (buffer has to outlive vectorize())
+	void load(const uint8_t *pixels, int width, int height, int channels, size_t stride); // Raw 8bit pixels: 1 = gray, 3 = RGB, 4 = RGBA
+	void vectorize(); // Run selected vectorizer on input
+	void write(FILE *fd); // Apply finisher settings and export vector image
+	void write(std::string &out); // Same, output is appended to string
+
+	parameters par;
+	pnm_image input;
+	v_image output;
+	double vectorization_time = 0; // in seconds
+	metrics met; // Stage times and counters of this job
+private:
+	int *param_vectorization_method;
+	int *param_output_engine;
+	std::string *param_custom_input_name;
+	std::string stream_name; // Input read by custom vectorizer band by band, empty = input is loaded
+
+	void finish(); // Apply finisher settings to output
+};
+
+}; // namespace
+
+#endif
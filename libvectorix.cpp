@@ -0,0 +1,53 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdint>
+#include <string>
+#include "libvectorix.h"
+#include "job.h"
+#include "v_image.h"
+#include "parameters.h"
+#include "metrics.h"
+
+// Library interface: vectorize images in memory, no files and no windows
+
+namespace vectorix {
+
+v_image vectorize_pixels(const uint8_t *pixels, int width, int height, int channels, size_t stride, const parameters &params, metrics *met) {
+	job j(params);
+	j.load(pixels, width, height, channels, stride);
+	j.vectorize();
+	if (met)
+		*met = j.met;
+	return j.output;
+}
+
+v_image vectorize_pnm(const void *buffer, size_t length, const parameters &params, metrics *met) {
+	job j(params);
+	j.load(buffer, length);
+	j.vectorize();
+	if (met)
+		*met = j.met;
+	return j.output;
+}
+
+void vectorize_pixels(const uint8_t *pixels, int width, int height, int channels, size_t stride, const parameters &params, std::string &out, metrics *met) {
+	job j(params);
+	j.load(pixels, width, height, channels, stride);
+	j.vectorize();
+	j.write(out);
+	if (met)
+		*met = j.met;
+}
+
+void vectorize_pnm(const void *buffer, size_t length, const parameters &params, std::string &out, metrics *met) {
+	job j(params);
+	j.load(buffer, length);
+	j.vectorize();
+	j.write(out);
+	if (met)
+		*met = j.met;
+}
+
+}; // namespace
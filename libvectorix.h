@@ -0,0 +1,34 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__LIBVECTORIX_H
+#define VECTORIX__LIBVECTORIX_H
+
+// Library interface: vectorize images in memory, no files and no windows
+//
+// Every call makes its own copy of given parameters, so calls may run in
+// parallel from many threads with one shared (unmodified) parameters object.
+// Errors are reported by exceptions (std::exception or plain const char *).
+
+#include <cstdint>
+#include <string>
+#include "v_image.h"
+#include "parameters.h"
+#include "metrics.h"
+
+namespace vectorix {
+
+// Raw 8bit pixels: channels 1 = gray, 3 = RGB, 4 = RGBA (alpha ignored), stride in bytes
+v_image vectorize_pixels(const uint8_t *pixels, int width, int height, int channels, size_t stride, const parameters &params, metrics *met = NULL);
+// Complete PNM file (P1-P6) in memory
+v_image vectorize_pnm(const void *buffer, size_t length, const parameters &params, metrics *met = NULL);
+// (Finisher settings are not applied to returned v_image, only to exported output)
+
+// Same as above, output is exported (svg or ps, by parameter output_engine) and appended to string
+void vectorize_pixels(const uint8_t *pixels, int width, int height, int channels, size_t stride, const parameters &params, std::string &out, metrics *met = NULL);
+void vectorize_pnm(const void *buffer, size_t length, const parameters &params, std::string &out, metrics *met = NULL);
+
+}; // namespace
+
+#endif
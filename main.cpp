@@ -18,6 +18,11 @@
 #include "parameters.h"
 #include "finisher.h"
 #include "zoom_window.h"
+#include "batch.h"
+#include "server.h"
+#include "pnm_filter.h"
+#include "metrics.h"
+#include "stream_decoder.h"
 #include <opencv2/opencv.hpp>
 
 using namespace std;
@@ -35,6 +40,7 @@ public:
 	std::string *vector_output_name;
 	std::string *pnm_output_name;
 	std::string *save_opencv_rendered_name;
+	std::string *metrics_output_name;
 	void bind(parameters &par) {
 		par.add_comment("# # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # # #");
 		par.add_comment("Vectorization method: 0: Custom, 1: Potrace, 2: Stupid");
@@ -52,6 +58,8 @@ public:
 		par.bind_param(vector_output_name, "file_vector_output", (std::string) "");
 		par.bind_param(pnm_output_name, "file_pnm_output", (std::string) "");
 		par.bind_param(save_opencv_rendered_name, "file_opencv_output", (std::string) "");
+		par.add_comment("Save stage times and work counters as JSON (file or /dev/fd/N): empty = no output");
+		par.bind_param(metrics_output_name, "file_metrics", (std::string) "");
 	}
 };
 
@@ -62,6 +70,9 @@ int main(int argc, char **argv) { // ./main [configuration]
 	parameters par;
 	main_params my_pars;
 	my_pars.bind(par);
+	batch bat(par);
+	server srv(par);
+	pnm_filter fil(par);
 
 	if (argc == 1) {
 		fprintf(stderr, "No config file given, new will be created, please enter name:\n");
@@ -80,12 +91,39 @@ int main(int argc, char **argv) { // ./main [configuration]
 
 	zoom_set_params(par);
 
+	/*
+	 * Batch mode, vectorize every image from list
+	 */
+	if (bat.enabled()) {
+		int failed = bat.run();
+		if (!my_pars.save_parameters_name->empty()) {
+			par.save_params(*my_pars.save_parameters_name, (*my_pars.save_parameters_append) == 1);
+		}
+		return !!failed;
+	}
+
+	/*
+	 * Server mode, vectorize images sent over Unix socket
+	 */
+	if (srv.enabled())
+		return srv.run();
+
+	/*
+	 * Filter mode, images from stdin to stdout
+	 */
+	if (fil.enabled())
+		return !!fil.run();
+
+	metrics met; // Stages record their times and counters here
+	metrics_scope met_scope(&met);
+
 	/*
 	 * Load input image
 	 */
 	FILE *svg_output = stdout;
 	FILE *pnm_output = NULL;
 	pnm_image input_image(par);
+	FILE *stream_input = NULL; // Input read by custom vectorizer band by band
 	if ((*my_pars.vectorization_method == 0) && (!my_pars.custom_input_name->empty())) { // Load input by OpenCV
 		fprintf(stderr, "File will be loaded by OpenCV.\n");
 	}
@@ -102,14 +140,21 @@ int main(int argc, char **argv) { // ./main [configuration]
 			fprintf(stderr, "Failed to read input image.\n");
 			return 1;
 		}
-		input_image.read(input); // Read from file
-		fclose(input);
+		stream_decoder dec(par);
+		if ((*my_pars.vectorization_method == 0) && dec.enabled() && dec.supported(*my_pars.pnm_input_name))
+			stream_input = input;
+		else {
+			stage_timer time("decode");
+			input_image.read(input); // Read from file
+			fclose(input);
+		}
 	}
 
 	/*
 	 * Vectorize image
 	 */
-	input_image.convert(pnm_variant_type::binary_ppm);
+	if (!stream_input && (input_image.type != pnm_variant_type::binary_pbm)) // Bitmaps are handled by vectorizers (without expanding to RGB)
+		input_image.convert(pnm_variant_type::binary_ppm);
 	v_image vector;
 	vectorizer *ve;
 	switch (*my_pars.vectorization_method) {
@@ -124,9 +169,15 @@ int main(int argc, char **argv) { // ./main [configuration]
 	}
 	timer vectorization_timer(0); // Measure time
 	vectorization_timer.start();
-		vector = ve->vectorize(input_image);
+		if (stream_input)
+			vector = static_cast<vectorizer_vectorix *>(ve)->vectorize_stream(stream_input);
+		else
+			vector = ve->vectorize(input_image);
 	vectorization_timer.stop();
+	if (stream_input)
+		fclose(stream_input);
 	fprintf(stderr, "Vectorization time: %fs\n", vectorization_timer.read());
+	met.add_time("vectorization", vectorization_timer.read());
 	delete ve;
 
 	/*
@@ -154,6 +205,7 @@ int main(int argc, char **argv) { // ./main [configuration]
 		input_image = re.render(vector); // Render bezier curves
 		render_timer.stop();
 		fprintf(stderr, "Render time: %fs\n", render_timer.read());
+		met.add_time("render", render_timer.read());
 		input_image.write(pnm_output); // Write rendered image to file
 		fclose(pnm_output);
 	}
@@ -161,6 +213,7 @@ int main(int argc, char **argv) { // ./main [configuration]
 	// Pre-export changes & transformations
 	finisher fin(par);
 	fin.apply_settings(vector);
+	met.add_output(vector);
 
 	/*
 	 * Save vector output to stdout / file specified in configfile
@@ -179,6 +232,20 @@ int main(int argc, char **argv) { // ./main [configuration]
 		if (svg_output != stdout)
 			fclose(svg_output);
 	}
+	/*
+	 * Save metrics
+	 */
+	if (!my_pars.metrics_output_name->empty()) {
+		FILE *metrics_output = fopen(my_pars.metrics_output_name->c_str(), "w");
+		if (metrics_output) {
+			const std::string &input_name = my_pars.custom_input_name->empty() ? *my_pars.pnm_input_name : *my_pars.custom_input_name;
+			met.write_json(metrics_output, input_name);
+			fclose(metrics_output);
+		}
+		else
+			fprintf(stderr, "Unable to write metrics to \"%s\".\n", my_pars.metrics_output_name->c_str());
+	}
+
 	/*
 	 * Save parameters
 	 */
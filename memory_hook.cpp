@@ -0,0 +1,60 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+#include "metrics.h"
+
+// Counting operator new and delete for memory metrics of stages
+//
+// Linked only to vectorix binary: library users and benchmarks keep their own allocator.
+// Size of freed block is taken from malloc, so no header is needed.
+
+using namespace vectorix;
+
+static bool hook_installed = (memory_counter::hooked = true);
+
+static inline void *counted_alloc(size_t size) {
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	long bytes = malloc_usable_size(ptr);
+	memory_counter::allocated += bytes;
+	memory_counter::live += bytes;
+	if (memory_counter::live > memory_counter::peak)
+		memory_counter::peak = memory_counter::live;
+	return ptr;
+}
+
+static inline void counted_free(void *ptr) {
+	if (!ptr)
+		return;
+	memory_counter::live -= malloc_usable_size(ptr);
+	free(ptr);
+}
+
+void *operator new(size_t size) {
+	return counted_alloc(size);
+}
+
+void *operator new[](size_t size) {
+	return counted_alloc(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	counted_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	counted_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	counted_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+	counted_free(ptr);
+}
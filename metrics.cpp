@@ -0,0 +1,105 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "v_image.h"
+#include "metrics.h"
+
+// Per-stage metrics
+
+namespace vectorix {
+
+thread_local metrics *metrics::current_ = NULL;
+thread_local stage_timer *stage_timer::running = NULL;
+
+bool memory_counter::hooked = false;
+thread_local long memory_counter::allocated = 0;
+thread_local long memory_counter::live = 0;
+thread_local long memory_counter::peak = 0;
+
+static const char *counter_names[] = {
+	"skeleton_pixels",
+	"start_points",
+	"predictions",
+	"fitness_pixels",
+	"approximation_iterations",
+	"offset_subdivisions",
+	"output_segments",
+};
+
+metrics::stage_time &metrics::find_stage(const std::string &name) {
+	for (auto &s: stages) {
+		if (s.name == name)
+			return s;
+	}
+	stages.push_back({name, 0, 0, 0, 0, 0});
+	return stages.back();
+}
+
+void metrics::add_time(const std::string &stage, double seconds) {
+	stage_time &s = find_stage(stage);
+	s.seconds += seconds;
+	s.runs++;
+}
+
+void metrics::add_memory(const std::string &stage, long allocated, long peak, long mat_bytes) {
+	stage_time &s = find_stage(stage);
+	s.allocated += allocated;
+	if (peak > s.peak)
+		s.peak = peak;
+	s.mat_bytes += mat_bytes;
+}
+
+void metrics::add_output(const v_image &image) {
+	for (const v_line &line: image.line) {
+		if (line.segment.size() > 1)
+			add(counter::output_segments, line.segment.size() - 1);
+	}
+}
+
+void metrics::merge(const metrics &other) {
+	for (int i = 0; i < (int) counter::count; i++)
+		counters[i] += other.counters[i];
+	threaded = true; // Other thread worked on the same image
+}
+
+static void write_string(FILE *fd, const std::string &str) { // JSON string with escaping
+	fputc('"', fd);
+	for (unsigned char c: str) {
+		if ((c == '"') || (c == '\\'))
+			fprintf(fd, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fd, "\\u%04x", c);
+		else
+			fputc(c, fd);
+	}
+	fputc('"', fd);
+}
+
+void metrics::write_json(FILE *fd, const std::string &input_name) const {
+	fprintf(fd, "{\"input\": ");
+	write_string(fd, input_name);
+	fprintf(fd, ", \"stages\": {");
+	for (int i = 0; i < (int) stages.size(); i++) {
+		fprintf(fd, "%s", i ? ", " : "");
+		write_string(fd, stages[i].name);
+		fprintf(fd, ": {\"seconds\": %.6f, \"runs\": %i", stages[i].seconds, stages[i].runs);
+		if (memory_counter::hooked && !threaded) // Heap counters are per thread
+			fprintf(fd, ", \"allocated_bytes\": %li, \"peak_bytes\": %li", stages[i].allocated, stages[i].peak);
+		fprintf(fd, ", \"mat_bytes\": %li}", stages[i].mat_bytes);
+	}
+	fprintf(fd, "}, \"counters\": {");
+	for (int i = 0; i < (int) counter::count; i++)
+		fprintf(fd, "%s\"%s\": %li", i ? ", " : "", counter_names[i], counters[i]);
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) // Whole process, includes other jobs running at once
+		fprintf(fd, "}, \"peak_rss_kb\": %li}\n", (long) usage.ru_maxrss);
+	else
+		fprintf(fd, "}}\n");
+}
+
+}; // namespace
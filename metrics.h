@@ -0,0 +1,135 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__METRICS_H
+#define VECTORIX__METRICS_H
+
+// Per-stage wall times and work counters of one vectorization, written as JSON
+//
+// Stages and helper functions record into metrics of current thread (if any),
+// threads started for one image have their own metrics and merge them after join.
+//
+// Memory of stage: heap bytes allocated and peak of live heap bytes (relative to
+// start of stage) are counted by replaced operator new (memory_hook.cpp, linked
+// only to vectorix binary) in thread running the stage. OpenCV allocates image
+// data by its own allocator, so stages report sizes of created cv::Mats by count_mat().
+// Heap counters are valid only for single-threaded runs: memory of worker threads
+// is not seen and memory freed by other thread is not subtracted. Metrics used by
+// more threads (parallel_for, pipeline) are marked and heap bytes are not written.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <utility>
+#include "v_image.h"
+#include "timer.h"
+
+namespace vectorix {
+
+enum class counter {
+	skeleton_pixels, // Pixels of skeleton
+	start_points, // Starting points consumed by tracer
+	predictions, // Calls of tracer::do_prediction
+	fitness_pixels, // Pixels visited by tracer::calculate_line_fitness
+	approximation_iterations, // Least squares iterations of approximation
+	offset_subdivisions, // Segments split while calculating outlines
+	output_segments, // Bezier segments in output
+	count // Number of counters
+};
+
+class memory_counter { // Heap usage of this thread, updated by memory_hook.cpp
+public:
+	static bool hooked; // Counting operator new is linked in
+	static thread_local long allocated; // Bytes allocated since start of thread
+	static thread_local long live; // Bytes allocated minus bytes freed by this thread
+	static thread_local long peak; // Maximum of live since last reset
+};
+
+class metrics {
+public:
+	void add(counter c, long value = 1) { counters[(int) c] += value; };
+	void add_time(const std::string &stage, double seconds); // Stage can run more times (interactive mode, tiles)
+	void add_memory(const std::string &stage, long allocated, long peak, long mat_bytes); // Heap and cv::Mat bytes of one run of stage
+	void add_output(const v_image &image); // Count output segments
+	void merge(const metrics &other); // Add counters of other thread (stage times are wall times of owner)
+	void set_threaded() { threaded = true; }; // Memory was allocated or freed by more threads, heap counters are not valid
+	void write_json(FILE *fd, const std::string &input_name) const; // One JSON object on one line
+
+	static metrics *current() { return current_; }; // Metrics of this thread, NULL = not measured
+	static void set_current(metrics *m) { current_ = m; };
+private:
+	class stage_time {
+	public:
+		std::string name;
+		double seconds;
+		int runs;
+		long allocated; // Sum of heap bytes allocated in all runs
+		long peak; // Maximum over runs of peak live heap bytes
+		long mat_bytes; // Sum of bytes of image data in all runs
+	};
+	stage_time &find_stage(const std::string &name); // Add new stage if needed
+	long counters[(int) counter::count] = {};
+	std::vector<stage_time> stages; // In order of first run
+	bool threaded = false;
+
+	static thread_local metrics *current_;
+};
+
+inline void count(counter c, long value = 1) { // Add to counter of current thread
+	if (metrics *m = metrics::current())
+		m->add(c, value);
+}
+
+class metrics_scope { // Use given metrics in this thread until end of scope
+public:
+	metrics_scope(metrics *m): previous(metrics::current()) { metrics::set_current(m); };
+	~metrics_scope() { metrics::set_current(previous); };
+private:
+	metrics *previous;
+};
+
+class stage_timer { // Measure wall time and memory of stage until end of scope
+public:
+	stage_timer(const char *stage_name): name(stage_name), t(0), previous(running) {
+		running = this;
+		allocated_start = memory_counter::allocated;
+		live_start = memory_counter::live;
+		peak_outer = memory_counter::peak;
+		memory_counter::peak = memory_counter::live;
+		t.start();
+	};
+	~stage_timer() {
+		t.stop();
+		long peak = memory_counter::peak;
+		if (peak_outer > peak) // Nested stages: keep peak of enclosing stage
+			memory_counter::peak = peak_outer;
+		running = previous;
+		if (metrics *m = metrics::current()) {
+			m->add_time(name, t.read());
+			m->add_memory(name, memory_counter::allocated - allocated_start, peak - live_start, mat_bytes);
+		}
+	};
+
+	static stage_timer *current() { return running; }; // Innermost stage of this thread, NULL = none
+	long mat_bytes = 0;
+private:
+	const char *name;
+	timer t;
+	stage_timer *previous;
+	long allocated_start;
+	long live_start;
+	long peak_outer;
+
+	static thread_local stage_timer *running;
+};
+
+template<class M>
+inline void count_mat(const M &mat) { // Add image data of newly created cv::Mat to running stage
+	if (stage_timer *s = stage_timer::current())
+		s->mat_bytes += mat.total() * mat.elemSize();
+}
+
+}; // namespace
+
+#endif
@@ -7,6 +7,7 @@
 #include "v_image.h"
 #include "parameters.h"
 #include "approximation.h"
+#include "metrics.h"
 #include <list>
 #include <vector>
 #include <cmath>
@@ -53,6 +54,7 @@ void offset::convert_to_outline(v_line &line) { // Calculate outline of each lin
 		else {
 			v_point middle;
 			geom::bezier_chop_in_half(*one, *two, middle);
+			count(counter::offset_subdivisions);
 			line.segment.insert(two, middle);
 			--two;
 		}
@@ -0,0 +1,57 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__PARALLEL_H
+#define VECTORIX__PARALLEL_H
+
+// Simple thread pool helpers
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include "metrics.h"
+
+namespace vectorix {
+
+inline int worker_count(int requested, int max_useful = 0) { // Resolve requested count of threads (0 = number of cores)
+	int workers = requested;
+	if (workers <= 0)
+		workers = std::thread::hardware_concurrency();
+	if (workers <= 0)
+		workers = 1;
+	if (max_useful > 0)
+		workers = std::min(workers, max_useful);
+	return workers;
+}
+
+// Call func(index, worker) for every index in [0, count) using given count of threads.
+// Indices are taken in increasing order, worker is in [0, workers) and can be used
+// to access per-thread data. Workers do not record into metrics of caller.
+template <typename F>
+void parallel_for(int count, int workers, F func) {
+	workers = std::max(1, std::min(workers, count));
+	if (workers == 1) { // No need for threads
+		for (int i = 0; i < count; i++)
+			func(i, 0);
+		return;
+	}
+	if (metrics *m = metrics::current())
+		m->set_threaded(); // Per-thread heap counters of running stage miss workers
+	std::atomic<int> next(0);
+	std::vector<std::thread> threads;
+	for (int w = 0; w < workers; w++) {
+		threads.emplace_back([&, w]() {
+			int i;
+			while ((i = next++) < count)
+				func(i, w);
+		});
+	}
+	for (auto &t: threads)
+		t.join();
+}
+
+}; // namespace
+
+#endif
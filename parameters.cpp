@@ -8,11 +8,20 @@
 #include <unordered_map>
 #include <vector>
 #include <cstring>
+#include <new>
 
 // Program parameters
 
 namespace vectorix {
 
+parameters::parameters(const parameters &other): not_loaded(other.not_loaded) { // Copy every parameter, so each copy can be used by different thread
+	for (auto const &par: other.parameter_list) {
+		std::shared_ptr<param> s = par->clone();
+		parameter_list.push_back(s);
+		binded_list.insert({s->name, s});
+	}
+}
+
 void parameters::load_params(FILE *fd) { // Load parameters from file
 	char *line;
 	int linenumber = 0;
@@ -95,6 +104,27 @@ void parameters::save_params(const std::string &filename, bool append) const { /
 	fclose(fd);
 }
 
+std::string parameters::fingerprint(const std::vector<std::string> &names) const { // Same output as save_params, but only for given parameters
+	char *buffer = NULL;
+	size_t size = 0;
+	FILE *fd = open_memstream(&buffer, &size);
+	if (!fd)
+		throw std::bad_alloc();
+	for (auto const &name: names) {
+		auto par = binded_list.find(name);
+		if (par != binded_list.end())
+			par->second->save_var(fd);
+		else {
+			auto lazy = not_loaded.find(name);
+			fprintf(fd, "%s %s\n", name.c_str(), (lazy != not_loaded.end()) ? lazy->second.c_str() : "");
+		}
+	}
+	fclose(fd);
+	std::string out(buffer, size);
+	free(buffer);
+	return out;
+}
+
 void parameters::add_comment(const char *name) {
 	std::shared_ptr<comment> s = std::make_shared<comment>();
 	s->name = ((std::string) "# ") + name;
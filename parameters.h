@@ -23,6 +23,7 @@ private:
 		virtual void save_var(FILE *fd) const = 0;
 		virtual void load_var(const char *new_val) = 0;
 		virtual void dafault_var() = 0;
+		virtual std::shared_ptr<param> clone() const = 0;
 		std::string name;
 	protected:
 		param() = default;
@@ -36,8 +37,15 @@ private:
 		};
 		virtual void load_var(const char *new_val) {};
 		virtual void dafault_var() {};
+		virtual std::shared_ptr<param> clone() const {
+			return std::make_shared<comment>(*this);
+		};
 	};
 public:
+	parameters() = default;
+	parameters(const parameters &other); // Deep copy, values can be changed independently on the original
+	parameters &operator=(const parameters &other) = delete;
+
 	template <typename T> void bind_param(T *&variable, const char *name, const T&def_value) {
 		std::shared_ptr<param_spec<T>> s = std::make_shared<param_spec<T>>();
 		s->def_value = def_value;
@@ -71,6 +79,7 @@ public:
 	void load_params(const std::string &filename); // Load parameters from file given by name
 	void save_params(FILE *fd) const; // Write to filedescriptor
 	void save_params(const std::string &filename, bool append = true) const; // Save parameters to file given by name
+	std::string fingerprint(const std::vector<std::string> &names) const; // Values of given parameters as text (for comparing and hashing)
 
 	std::vector<std::shared_ptr<param>> parameter_list;
 	std::unordered_map<std::string, std::string> not_loaded;
@@ -80,6 +89,9 @@ public:
 template <>
 class parameters::param_spec<int>: public param {
 public:
+	virtual std::shared_ptr<param> clone() const {
+		return std::make_shared<param_spec<int>>(*this);
+	};
 	virtual void save_var(FILE *fd) const {
 		fprintf(fd, "%s %i\n", name.c_str(), value);
 	};
@@ -96,6 +108,9 @@ public:
 template <>
 class parameters::param_spec<float>: public param {
 public:
+	virtual std::shared_ptr<param> clone() const {
+		return std::make_shared<param_spec<float>>(*this);
+	};
 	virtual void save_var(FILE *fd) const {
 		fprintf(fd, "%s %f\n", name.c_str(), value);
 	};
@@ -112,6 +127,9 @@ public:
 template <>
 class parameters::param_spec<double>: public param {
 public:
+	virtual std::shared_ptr<param> clone() const {
+		return std::make_shared<param_spec<double>>(*this);
+	};
 	virtual void save_var(FILE *fd) const {
 		fprintf(fd, "%s %f\n", name.c_str(), value);
 	};
@@ -128,6 +146,9 @@ public:
 template <>
 class parameters::param_spec<std::string>: public param {
 public:
+	virtual std::shared_ptr<param> clone() const {
+		return std::make_shared<param_spec<std::string>>(*this);
+	};
 	virtual void save_var(FILE *fd) const {
 		fprintf(fd, "%s %s\n", name.c_str(), value.c_str());
 	};
@@ -0,0 +1,223 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include "pipeline.h"
+#include "bounded_queue.h"
+#include "job.h"
+#include "parameters.h"
+#include "pnm_handler.h"
+#include "vectorizer_vectorix.h"
+#include "thresholder.h"
+#include "skeletonizer.h"
+#include "tracer.h"
+#include "approximation.h"
+#include "tiler.h"
+#include "stage_cache.h"
+#include "timer.h"
+#include "metrics.h"
+#include "stream_decoder.h"
+
+// Streaming batch executor
+
+using namespace cv;
+
+namespace vectorix {
+
+bool pipeline::supported(const parameters &params) {
+	parameters copy(params);
+	int *param_vectorization_method;
+	copy.bind_param(param_vectorization_method, "vectorization_method", 0);
+	tiler til(copy);
+	stage_cache cache(copy);
+	stream_decoder dec(copy);
+	return (*param_vectorization_method == 0) && !til.enabled() && !cache.enabled() && !dec.enabled();
+}
+
+/*
+ * Stages
+ */
+
+void pipeline::decode(pipeline_frame &f) {
+	f.j.load(f.name); // Times itself as "decode"
+	stage_timer time("load"); // Conversion for OpenCV, as in vectorizer_vectorix::load_image()
+	std::string *param_custom_input_name;
+	f.j.par.bind_param(param_custom_input_name, "file_input", (std::string) "");
+	thresholder thr(f.j.par);
+	if (param_custom_input_name->empty() && (f.j.input.type == pnm_variant_type::binary_pbm) && thr.bitmap_supported())
+		return; // Bitmap is unpacked by threshold stage, there is no color image
+	if (param_custom_input_name->empty()) {
+		f.j.input.convert(pnm_variant_type::binary_ppm);
+		vectorizer_vectorix::pnm_to_mat(f.j.input, f.orig); // No copy, input is kept until tracing is done
+		f.rgb = true;
+	}
+	else {
+		f.orig = imread(*param_custom_input_name, CV_LOAD_IMAGE_COLOR);
+		if (!f.orig.data)
+			throw("Unable to read input image");
+		count_mat(f.orig);
+	}
+}
+
+void pipeline::threshold(pipeline_frame &f) {
+	thresholder thr(f.j.par);
+	skeletonizer ske(f.j.par);
+	bool bits = !thr.filter_enabled() && ske.bits_supported(); // Bit-packed image is passed to skeletonizer
+	if (f.orig.empty()) { // Bitmap input
+		if (!bits) {
+			thr.from_bitmap(f.j.input, f.binary);
+			thr.filter(f.binary);
+		}
+		else
+			thr.from_bitmap(f.j.input, f.bits);
+		f.j.input = pnm_image(f.j.par); // Free memory
+	}
+	else {
+		thr.set_rgb_order(f.rgb);
+		if (!bits)
+			thr.run(f.orig, f.binary);
+		else
+			thr.threshold(f.orig, f.bits);
+	}
+}
+
+void pipeline::skeletonize(pipeline_frame &f) {
+	skeletonizer ske(f.j.par);
+	if (f.bits.empty())
+		ske.run(f.binary, f.skeleton, f.distance);
+	else
+		ske.run(f.bits, f.skeleton, f.distance);
+	f.binary = Mat();
+	f.bits = bit_mat();
+}
+
+void pipeline::trace(pipeline_frame &f) {
+	tracer tra(f.j.par);
+	f.traced = v_image(f.skeleton.cols, f.skeleton.rows);
+	tra.set_rgb_order(f.rgb);
+	tra.run(f.orig, f.skeleton, f.distance, f.traced);
+	f.orig = Mat();
+	f.j.input = pnm_image(f.j.par); // Free memory
+	f.skeleton = Mat();
+	f.distance = Mat();
+}
+
+void pipeline::approximate(pipeline_frame &f) {
+	approximation apx(f.j.par);
+	f.j.output = f.traced;
+	f.traced = v_image();
+	apx.run(f.j.output);
+}
+
+void pipeline::run_stage(const stage &s, pipeline_frame &f) {
+	if (!f.error.empty())
+		return; // Failed in some previous stage
+	metrics_scope scope(&f.j.met); // Stages record to metrics of frame
+	f.j.met.set_threaded(); // Frame moves between threads, buffers are freed by other stage than allocated them
+	timer stage_timer(0);
+	stage_timer.start();
+	try {
+		s.func(f);
+	}
+	catch (const std::exception &e) {
+		f.error = e.what();
+	}
+	catch (const char *e) { // Vectorizer throws plain strings
+		f.error = e;
+	}
+	catch (...) {
+		f.error = "Unknown error.";
+	}
+	stage_timer.stop();
+	f.time += stage_timer.read();
+}
+
+/*
+ * Scheduling
+ */
+
+void pipeline::run(const std::vector<std::string> &names, std::function<void(pipeline_frame &)> output) {
+	typedef std::unique_ptr<pipeline_frame> frame_ptr;
+	// Light stages need one thread, CPU-heavy ones get all workers
+	std::vector<stage> stages = {
+		{"decode", 1, decode},
+		{"threshold", 1, threshold},
+		{"skeletonization", workers_, skeletonize},
+		{"tracing", workers_, trace},
+		{"approximation", workers_, approximate},
+	};
+	int count = names.size();
+
+	// queues[s] is output of stage s, the last one is read by output
+	std::vector<std::unique_ptr<bounded_queue<frame_ptr>>> queues;
+	std::vector<std::unique_ptr<std::atomic<int>>> running; // Threads of each stage still working
+	int in_flight = 0;
+	for (auto &s: stages) {
+		queues.emplace_back(new bounded_queue<frame_ptr>(queue_size_));
+		running.emplace_back(new std::atomic<int>(s.threads));
+		in_flight += queue_size_ + s.threads;
+	}
+
+	// Limit frames waiting in reorder buffer (one slow frame must not let others pile up)
+	std::mutex window_mutex;
+	std::condition_variable window_moved;
+	int emitted = 0;
+	std::atomic<int> next(0);
+
+	std::vector<std::thread> threads;
+	for (int s = 0; s < (int) stages.size(); s++) {
+		for (int t = 0; t < stages[s].threads; t++) {
+			threads.emplace_back([&, s]() {
+				frame_ptr f;
+				while (true) {
+					if (s == 0) { // Take next image from input list
+						int i = next++;
+						if (i >= count)
+							break;
+						{
+							std::unique_lock<std::mutex> lock(window_mutex);
+							window_moved.wait(lock, [&]() { return i < emitted + in_flight; });
+						}
+						f = frame_ptr(new pipeline_frame(*snapshot, i, names[i]));
+					}
+					else if (!queues[s - 1]->pop(f))
+						break;
+					run_stage(stages[s], *f);
+					queues[s]->push(std::move(f));
+				}
+				if (!--*running[s]) // Last thread of this stage
+					queues[s]->close();
+			});
+		}
+	}
+
+	// Reorder buffer: output in input order
+	std::map<int, frame_ptr> waiting;
+	frame_ptr f;
+	while (queues.back()->pop(f)) {
+		int index = f->index;
+		waiting[index] = std::move(f);
+		while (!waiting.empty() && (waiting.begin()->first == emitted)) {
+			output(*waiting.begin()->second);
+			waiting.erase(waiting.begin());
+			std::lock_guard<std::mutex> lock(window_mutex);
+			emitted++;
+			window_moved.notify_all();
+		}
+	}
+	for (auto &t: threads)
+		t.join();
+}
+
+}; // namespace
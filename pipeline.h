@@ -0,0 +1,70 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__PIPELINE_H
+#define VECTORIX__PIPELINE_H
+
+// Streaming batch executor: decoding, thresholding, skeletonization, tracing and
+// approximation run in their own threads connected by bounded queues, so I/O and
+// light stages overlap with tracing. Frames are passed to output in input order.
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <functional>
+#include "job.h"
+#include "v_image.h"
+#include "parameters.h"
+#include "bit_mat.h"
+
+namespace vectorix {
+
+class pipeline_frame { // One image travelling through pipeline
+public:
+	pipeline_frame(const parameters &params, int idx, const std::string &filename): j(params), index(idx), name(filename) {};
+	job j; // Private parameters, vector output in j.output
+	int index; // Position in input list
+	std::string name;
+
+	cv::Mat orig; // Wraps data of j.input for PNM images
+	bool rgb = false; // Channel order of orig: RGB (PNM input) or BGR (loaded by OpenCV)
+	cv::Mat binary;
+	bit_mat bits; // Thresholded image when no filter is used (instead of binary)
+	cv::Mat skeleton;
+	cv::Mat distance;
+	v_image traced;
+
+	double time = 0; // Sum of stage times (in seconds)
+	std::string error; // Non-empty: stage failed, following stages are skipped
+};
+
+class pipeline {
+public:
+	pipeline(const parameters &params, int workers, int queue_size): snapshot(&params), workers_(workers), queue_size_(queue_size) {};
+	static bool supported(const parameters &params); // Only custom vectorizer without tiling and caching is split into stages
+
+	// Process all images, output is called from one thread in order of names
+	void run(const std::vector<std::string> &names, std::function<void(pipeline_frame &)> output);
+private:
+	class stage {
+	public:
+		const char *name;
+		int threads;
+		std::function<void(pipeline_frame &)> func;
+	};
+	static void decode(pipeline_frame &f);
+	static void threshold(pipeline_frame &f);
+	static void skeletonize(pipeline_frame &f);
+	static void trace(pipeline_frame &f);
+	static void approximate(pipeline_frame &f);
+	static void run_stage(const stage &s, pipeline_frame &f); // Run stage function, failures are stored in frame
+
+	const parameters *snapshot;
+	int workers_;
+	int queue_size_;
+};
+
+}; // namespace
+
+#endif
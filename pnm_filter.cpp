@@ -0,0 +1,107 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdio>
+#include <string>
+#include <memory>
+#include <thread>
+#include <exception>
+#include "pnm_filter.h"
+#include "bounded_queue.h"
+#include "job.h"
+#include "parameters.h"
+#include "logger.h"
+
+// Filter mode: PNM images from stdin, vector images to stdout
+
+namespace vectorix {
+
+class filter_frame {
+public:
+	std::unique_ptr<job> j; // Loaded image
+	std::string error; // Parsing failed, no more frames follow
+};
+
+static bool next_frame(FILE *fd) { // Skip whitespace between images, false at end of input
+	int c;
+	while (((c = getc(fd)) != EOF) && ((c == ' ') || (c == '\n') || (c == '\r') || (c == '\t')))
+		;
+	if (c == EOF)
+		return false;
+	ungetc(c, fd);
+	return true;
+}
+
+void pnm_filter::output(const std::string &document) {
+	if (*param_filter_length_prefix)
+		fprintf(stdout, "%zu\n", document.size());
+	fwrite(document.data(), 1, document.size(), stdout);
+	fflush(stdout); // Consumer can process this image now
+}
+
+int pnm_filter::run() {
+	parameters snapshot(*par); // Every image gets its own copy of these parameters
+	bounded_queue<filter_frame> frames(*param_filter_queue_size);
+
+	std::thread reader([&]() {
+		while (next_frame(stdin)) {
+			filter_frame f;
+			try {
+				f.j = std::unique_ptr<job>(new job(snapshot));
+				f.j->load(stdin);
+			}
+			catch (const std::exception &e) {
+				f.error = e.what();
+			}
+			catch (const char *e) {
+				f.error = e;
+			}
+			catch (...) { // Exception must not leave the thread
+				f.error = "Unknown error.";
+			}
+			bool failed = !f.error.empty();
+			if (!frames.push(std::move(f)) || failed)
+				break; // Position in stream is lost after error
+		}
+		frames.close();
+	});
+
+	int count = 0, failed = 0;
+	filter_frame f;
+	while (frames.pop(f)) {
+		count++;
+		std::string document, error = f.error;
+		if (error.empty()) {
+			try {
+				f.j->vectorize();
+				f.j->write(document);
+			}
+			catch (const std::exception &e) {
+				error = e.what();
+			}
+			catch (const char *e) { // Vectorizer throws plain strings
+				error = e;
+			}
+			catch (...) {
+				error = "Unknown error.";
+			}
+		}
+		f.j.reset();
+		if (error.empty()) {
+			log.log<log_level::debug>("Filter: image %i vectorized\n", count);
+			output(document);
+		}
+		else {
+			failed++;
+			log.log<log_level::error>("Filter: image %i failed: %s\n", count, error.c_str());
+			if (*param_filter_length_prefix)
+				output(""); // Keep numbering of documents
+		}
+	}
+	reader.join();
+	log.log<log_level::info>("Filter: %i images, %i failed\n", count, failed);
+	return failed;
+}
+
+}; // namespace
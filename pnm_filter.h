@@ -0,0 +1,50 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__PNM_FILTER_H
+#define VECTORIX__PNM_FILTER_H
+
+// Filter mode: concatenated PNM images are read from stdin, one vector image
+// per input image is written to stdout. Next image is parsed (own thread)
+// while current one is vectorized.
+//
+// With length prefix every output document is preceded by line with its size
+// in bytes; failed image is written as empty document ("0\n").
+
+#include <string>
+#include "parameters.h"
+#include "logger.h"
+
+namespace vectorix {
+
+class pnm_filter {
+public:
+	pnm_filter(parameters &params): par(&params) {
+		int *param_filter_verbosity;
+		par->bind_param(param_filter_verbosity, "filter_verbosity", (int) log_level::info);
+		log.set_verbosity((log_level) *param_filter_verbosity);
+
+		par->add_comment("Filter mode: 0: off, 1: read PNM images from stdin, write vector images to stdout");
+		par->bind_param(param_filter_mode, "filter_mode", 0);
+		par->add_comment("Filter mode output: 0: documents one after another, 1: every document is preceded by line with its length");
+		par->bind_param(param_filter_length_prefix, "filter_length_prefix", 0);
+		par->add_comment("Count of parsed images waiting for vectorization");
+		par->bind_param(param_filter_queue_size, "filter_queue_size", 2);
+	};
+	bool enabled() const { return *param_filter_mode != 0; };
+	int run(); // Process images until end of input, returns count of failed ones
+private:
+	int *param_filter_mode;
+	int *param_filter_length_prefix;
+	int *param_filter_queue_size;
+
+	void output(const std::string &document); // Write one document to stdout
+
+	logger log;
+	parameters *par;
+};
+
+}; // namespace
+
+#endif
@@ -5,62 +5,152 @@
 #include <utility>
 #include <cstdio>
 #include <cstdlib>
-#include <cstdarg>
+#include <cstdint>
+#include <climits>
+#include <vector>
 #include <cstring>
 #include <stdexcept>
+#include <cctype>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "pnm_handler.h"
+#include "pnm_kernels.h"
 
 // Manipulation with Netpbm format images
 
 namespace vectorix {
 
-int pnm_image::fscanf_comment(FILE *stream, const char *format, ...) { // Read line from PNM header, ignore comments
-	char line[64]; // Longer lines are used only for comments
-	bool comment_continuation = false;
-	for (;;) {
-		fgets(line, 64, stream); // Read max one line
-		if (!line[0]) // Check if read was successfull
-			return 0;
-		if (comment_continuation || (line[0] == '#')) { // Line starting with '#' is commented and should be skipped
-			if (strchr(line, '\n'))
-				comment_continuation = false;
-			else
-				comment_continuation = true; // Skip also next buffer contest - continuation of comment
-			continue;
+static inline bool is_space(int c) { // Whitespace in PNM header and ASCII data (no locale lookup)
+	return (c == ' ') || (c == '\n') || (c == '\r') || (c == '\t') || (c == '\v') || (c == '\f');
+}
+
+static inline bool is_digit(int c) {
+	return (c >= '0') && (c <= '9');
+}
+
+static bool skip_whitespace(const pnm_data_t *&pos, const pnm_data_t *end) { // Skip whitespace and comments in PNM header
+	while (pos < end) {
+		if (*pos == '#') { // Comment continues to the end of line
+			while ((pos < end) && (*pos != '\n'))
+				pos++;
 		}
+		else if (is_space(*pos))
+			pos++;
 		else
+			return true;
+	}
+	return false;
+}
+
+static bool parse_number(const pnm_data_t *&pos, const pnm_data_t *end, int &number) { // Read decimal number from PNM header
+	if (!skip_whitespace(pos, end) || !is_digit(*pos))
+		return false;
+	number = 0;
+	while ((pos < end) && is_digit(*pos)) {
+		if (number > 100000000) // Too big for any image
+			return false;
+		number = number*10 + (*pos++ - '0');
+	}
+	return true;
+}
+
+static int skip_whitespace(FILE *fd) { // Same for stream, returns first other character
+	int c;
+	while ((c = getc_unlocked(fd)) != EOF) {
+		if (c == '#') {
+			while (((c = getc_unlocked(fd)) != EOF) && (c != '\n'))
+				;
+		}
+		else if (!is_space(c))
 			break;
 	}
-	va_list args;
-	va_start(args, format);
-	int ret = vsscanf(line, format, args);
-	va_end(args);
-	return ret;
+	return c;
 }
 
-bool pnm_image::read_header(FILE *fd) { // Read image header and clear old data.
-	char magic, ntype;
-	if (fscanf_comment(fd, "%c%c\n", &magic, &ntype) != 2 || magic != 'P' || ntype < '1' || ntype > '6') { // First line contains magicvalue P and type (1-6)
-		log.log<log_level::error>("Error reading image header.\n");
+static bool parse_number(FILE *fd, int &number) {
+	int c = skip_whitespace(fd);
+	if (!is_digit(c))
 		return false;
+	number = 0;
+	while (is_digit(c)) {
+		if (number > 100000000)
+			return false;
+		number = number*10 + (c - '0');
+		c = getc_unlocked(fd);
 	}
-	if (fscanf_comment(fd, "%i%i\n", &width, &height) != 2) { // Image dimensions width and height
+	if (c != EOF)
+		ungetc(c, fd); // Caller checks the separator
+	return true;
+}
+
+bool pnm_image::set_header(char ntype, int max) {
+	if ((width <= 0) || (height <= 0)) {
 		log.log<log_level::error>("Error reading image dimensions.\n");
 		return false;
 	}
-	if (ntype != '1' && ntype != '4') { // Everything except bitmap (0/1) images
-		if (fscanf_comment(fd, "%i\n", &maxvalue) != 1) { // Maximal value of pixel
-			log.log<log_level::error>("Error reading image maxvalue.\n");
-			return false;
-		}
+	if ((max < 1) || (max > 255)) { // Only 8bit images are supported
+		log.log<log_level::error>("Unsupported image maxvalue %i.\n", max);
+		return false;
 	}
+	int channels = ((ntype == '3') || (ntype == '6')) ? 3 : 1;
+	if ((uint64_t) width * height * channels > INT_MAX) { // Pixels are indexed by int
+		log.log<log_level::error>("Image %ix%i is too big.\n", width, height);
+		return false;
+	}
+	maxvalue = max;
 	type = (pnm_variant_type) (ntype - '0'); // Convert type to int
-	if (data)
-		delete[] data; // Drop old data
-	data = NULL;
+	drop_data(); // Drop old data
 	return true;
 }
 
+bool pnm_image::read_header(FILE *fd) { // Read image header and clear old data, fd is moved to first byte of data
+	int magic = getc_unlocked(fd);
+	int ntype = getc_unlocked(fd);
+	if ((magic != 'P') || (ntype < '1') || (ntype > '6')) { // Magic value P and type (1-6)
+		log.log<log_level::error>("Error reading image header.\n");
+		return false;
+	}
+	if (!parse_number(fd, width) || !parse_number(fd, height)) { // Image dimensions width and height
+		log.log<log_level::error>("Error reading image dimensions.\n");
+		return false;
+	}
+	int max = 1;
+	if ((ntype != '1') && (ntype != '4') && !parse_number(fd, max)) { // Maximal value of pixel, everything except bitmap (0/1) images
+		log.log<log_level::error>("Error reading image maxvalue.\n");
+		return false;
+	}
+	if (!is_space(getc_unlocked(fd))) { // Exactly one whitespace before data
+		log.log<log_level::error>("Error reading image header.\n");
+		return false;
+	}
+	return set_header(ntype, max);
+}
+
+bool pnm_image::read_header(const pnm_data_t *&pos, const pnm_data_t *end) { // Parse image header from memory, pos is moved to first byte of data
+	if ((end - pos < 2) || (pos[0] != 'P') || (pos[1] < '1') || (pos[1] > '6')) { // Magic value P and type (1-6)
+		log.log<log_level::error>("Error reading image header.\n");
+		return false;
+	}
+	char ntype = pos[1];
+	pos += 2;
+	if (!parse_number(pos, end, width) || !parse_number(pos, end, height)) { // Image dimensions width and height
+		log.log<log_level::error>("Error reading image dimensions.\n");
+		return false;
+	}
+	int max = 1;
+	if ((ntype != '1') && (ntype != '4') && !parse_number(pos, end, max)) { // Maximal value of pixel, everything except bitmap (0/1) images
+		log.log<log_level::error>("Error reading image maxvalue.\n");
+		return false;
+	}
+	if ((pos >= end) || !is_space(*pos)) { // Exactly one whitespace before data
+		log.log<log_level::error>("Error reading image header.\n");
+		return false;
+	}
+	pos++;
+	return set_header(ntype, max);
+}
+
 void pnm_image::write_header(FILE *fd) { // Write image header
 	fprintf(fd, "P%c\n", (int) type + '0'); // Image type
 	fprintf(fd, "%i %i\n", width, height); // Dimensions
@@ -69,34 +159,135 @@ void pnm_image::write_header(FILE *fd) { // Write image header
 	}
 }
 
-void pnm_image::read(FILE *fd) { // Read image from file
-	if (!read_header(fd))
+void pnm_image::read_ascii_data(const pnm_data_t *&pos, const pnm_data_t *end) { // Hand-written parser, numbers are separated by whitespace or comments
+	int nsize = size();
+	data = new pnm_data_t [nsize]; // Alocate buffer
+	for (int i = 0; i < nsize; i++) {
+		if (!skip_whitespace(pos, end) || !is_digit(*pos)) {
+			log.log<log_level::error>("Error: reading image data failed at position %i.\n", i);
+			throw std::underflow_error("Unable to read image data.");
+		}
+		int value = *pos++ - '0';
+		if (type != pnm_variant_type::ascii_pbm) { // Sometimes there are no spaces between bitmap pixels
+			while ((pos < end) && is_digit(*pos) && (value <= 255))
+				value = value*10 + (*pos++ - '0');
+		}
+		if (value > maxvalue) {
+			log.log<log_level::error>("Error: pixel value %i at position %i exceeds maxvalue.\n", value, i);
+			throw std::underflow_error("Unable to read image data.");
+		}
+		data[i] = value;
+	}
+}
+
+bool pnm_image::read_mapped(FILE *fd) { // Map regular file, parse header in memory and use binary data in place
+	struct stat st;
+	long offset = ftell(fd); // Image can start inside of file (more images in one file)
+	if ((offset < 0) || (fstat(fileno(fd), &st) != 0) || !S_ISREG(st.st_mode) || (st.st_size <= offset))
+		return false;
+	size_t length = st.st_size;
+	void *addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(fd), 0); // Private: writes to data never reach the file
+	if (addr == MAP_FAILED)
+		return false;
+	std::shared_ptr<void> file(addr, [length](void *a) { munmap(a, length); });
+	madvise(addr, length, MADV_SEQUENTIAL);
+
+	const pnm_data_t *pos = static_cast<const pnm_data_t *>(addr) + offset;
+	const pnm_data_t *end = static_cast<const pnm_data_t *>(addr) + length;
+	if (!read_header(pos, end))
+		throw std::underflow_error("Unable to read image header.");
+#ifdef VECTORIX_PNM_DEBUG
+	write_header(stderr);
+#endif
+	if (type < pnm_variant_type::binary_pbm) // ASCII images have to be parsed
+		read_ascii_data(pos, end);
+	else {
+		if ((size_t) (end - pos) < size()) {
+			log.log<log_level::error>("Error: image data are truncated (%zu of %zu bytes).\n", (size_t) (end - pos), size());
+			throw std::underflow_error("Unable to read image data.");
+		}
+		data = const_cast<pnm_data_t *>(pos);
+		owns_data = false;
+		mapping = file;
+		pos += size();
+	}
+	fseek(fd, pos - static_cast<const pnm_data_t *>(addr), SEEK_SET); // Next image (if any) starts here
+	return true;
+}
+
+void pnm_image::read_info(FILE *fd) {
+	flockfile(fd);
+	bool header = read_header(fd);
+	funlockfile(fd);
+	if (!header)
 		throw std::underflow_error("Unable to read image header.");
+}
+
+void pnm_image::read(FILE *fd) { // Read image from file
+	if (read_mapped(fd))
+		return;
+
+	// Pipe or other stream, read header by characters and data in bulk
+	read_info(fd);
 
 	int nsize = size(); // Calculate size for data
 #ifdef VECTORIX_PNM_DEBUG
 	write_header(stderr);
 #endif
 
-	if (nsize) {
-		char scanf_string[8];
-		if (type == pnm_variant_type::ascii_pbm)
-			strcpy(scanf_string, "%1i"); // Sometimes there are no spaces between numbers
-		else if (type <= pnm_variant_type::ascii_ppm)
-			strcpy(scanf_string, "%i"); // Whitespace between numbers are mandatory
-		else if (type >= pnm_variant_type::binary_pbm)
-			strcpy(scanf_string, "%c"); // Binary data
-
+	if (!nsize)
+		return;
+	if (type >= pnm_variant_type::binary_pbm) { // Binary data
 		data = new pnm_data_t [nsize]; // Alocate buffer
-		for (int i = 0; i < nsize; i++) {
-			int read;
-			if (fscanf(fd, scanf_string, &read) != 1) { // Read image data
-				log.log<log_level::error>("Error: reading image data failed at position %i.\n", i);
-				throw std::underflow_error("Unable to read image data.");
+		size_t got = fread(data, 1, nsize, fd);
+		if (got != (size_t) nsize) {
+			log.log<log_level::error>("Error: reading image data failed at position %i.\n", (int) got);
+			throw std::underflow_error("Unable to read image data.");
+		}
+	}
+	else { // ASCII data, read until all pixels are parsed (stream can contain more images)
+		std::vector<pnm_data_t> text;
+		flockfile(fd);
+		int c, pixels = 0;
+		bool in_number = false, in_comment = false;
+		while ((pixels < nsize) && ((c = getc_unlocked(fd)) != EOF)) {
+			text.push_back(c);
+			if (in_comment)
+				in_comment = (c != '\n');
+			else if (c == '#')
+				in_comment = true;
+			else if (is_digit(c)) {
+				if (type == pnm_variant_type::ascii_pbm)
+					pixels++;
+				in_number = true;
+			}
+			else if (in_number) { // Whitespace (or garbage) after number
+				if (type != pnm_variant_type::ascii_pbm)
+					pixels++;
+				in_number = false;
 			}
-			data[i] = read;
 		}
+		funlockfile(fd);
+		const pnm_data_t *pos = text.data();
+		read_ascii_data(pos, pos + text.size());
+	}
+}
+
+void pnm_image::map(const void *buffer, size_t length) { // Use image data from buffer directly
+	const pnm_data_t *pos = static_cast<const pnm_data_t *>(buffer);
+	const pnm_data_t *end = pos + length;
+	if (!read_header(pos, end))
+		throw std::underflow_error("Unable to read image header.");
+	if (type < pnm_variant_type::binary_pbm) { // ASCII images have to be parsed
+		read_ascii_data(pos, end);
+		return;
+	}
+	if ((size_t) (end - pos) < size()) {
+		log.log<log_level::error>("Error: image data are truncated (%zu of %zu bytes).\n", (size_t) (end - pos), size());
+		throw std::underflow_error("Unable to read image data.");
 	}
+	data = const_cast<pnm_data_t *>(pos); // Image is never written through this pointer unless it is copied first
+	owns_data = false;
 }
 
 void pnm_image::write(FILE *fd) { // Save whole image
@@ -109,13 +300,28 @@ void pnm_image::write(FILE *fd) { // Save whole image
 	write_header(fd);
 	int nsize = size();
 	if (nsize && (type <= pnm_variant_type::ascii_ppm)) { // All ASCII images
-		for (int i = 0; i < nsize; i++)
-			fprintf(fd, "%i ", data[i]); // We are printing spaces in ASCII_PBM images even it is not necesary
-	}
-	if (nsize && (type >= pnm_variant_type::binary_pbm)) { // All binary images
+		char buffer[1 << 16]; // Formatted in chunks, one fwrite per chunk
+		char *out = buffer;
 		for (int i = 0; i < nsize; i++) {
-			fprintf(fd, "%c", data[i]);
+			if (out > buffer + sizeof(buffer) - 4) { // Room for "255 "
+				fwrite(buffer, 1, out - buffer, fd);
+				out = buffer;
+			}
+			unsigned value = data[i];
+			if (value >= 100) {
+				*out++ = '0' + value / 100;
+				*out++ = '0' + value / 10 % 10;
+			}
+			else if (value >= 10)
+				*out++ = '0' + value / 10;
+			*out++ = '0' + value % 10;
+			*out++ = ' '; // We are printing spaces in ASCII_PBM images even it is not necesary
 		}
+		fwrite(buffer, 1, out - buffer, fd);
+	}
+	if (nsize && (type >= pnm_variant_type::binary_pbm)) { // All binary images
+		if (fwrite(data, 1, nsize, fd) != (size_t) nsize)
+			log.log<log_level::error>("Error: writing image data failed.\n");
 	}
 }
 
@@ -123,51 +329,49 @@ void pnm_image::convert(pnm_variant_type new_type) {
 	if (type == new_type) // Nothing to convert, we are already there
 		return;
 
+	if (type == pnm_variant_type::binary_pbm) { // Unpack bits to ASCII bitmap, then convert as usual
+		auto bitmap = pnm_image(width, height, pnm_variant_type::ascii_pbm, *par);
+		int row_bytes = (width - 1) / 8 + 1;
+		for (int r = 0; r < height; r++)
+			pnm_kernels::unpack_bits(data + r*row_bytes, bitmap.data + r*width, width, 1, 0);
+		*this = std::move(bitmap);
+		convert(new_type);
+		return;
+	}
+
 	auto dest = pnm_image(width, height, new_type, *par);
 	int new_size = dest.size();
 
 	int convert_type = (type <= pnm_variant_type::ascii_ppm) ? (int) type : (int) type - 3; // Forget about binary/ascii
 	convert_type |= ((dest.type <= pnm_variant_type::ascii_ppm) ? (int) dest.type : (int) dest.type - 3) << 4; // lower two bits: original type; upper two bits: destination type
 
-	if ((((convert_type&3) == (int)pnm_variant_type::ascii_pgm) || (type == pnm_variant_type::ascii_pbm)) && (dest.type == pnm_variant_type::binary_pbm)) { // Convert (ascii/binary) grayscale (or ascii bitmap) to binary bitmap image
+	int row_bytes = (width - 1) / 8 + 1; // Binary bitmap row
+	if ((type == pnm_variant_type::ascii_pbm) && (dest.type == pnm_variant_type::binary_pbm)) { // Pack ascii bitmap (1 is black, as in binary bitmap)
 		for (int r = 0; r < height; r++) {
-			for (int i = 0; i <= (width - 1)/8; i++) {
-				dest.data[r*((width-1)/8+1) + i] = \
-					(((i*8+0 >= width) || (data[r*width+i*8+0] > maxvalue/2)) ? 0x00 : 0x80) | \
-					(((i*8+1 >= width) || (data[r*width+i*8+1] > maxvalue/2)) ? 0x00 : 0x40) | \
-					(((i*8+2 >= width) || (data[r*width+i*8+2] > maxvalue/2)) ? 0x00 : 0x20) | \
-					(((i*8+3 >= width) || (data[r*width+i*8+3] > maxvalue/2)) ? 0x00 : 0x10) | \
-					(((i*8+4 >= width) || (data[r*width+i*8+4] > maxvalue/2)) ? 0x00 : 0x08) | \
-					(((i*8+5 >= width) || (data[r*width+i*8+5] > maxvalue/2)) ? 0x00 : 0x04) | \
-					(((i*8+6 >= width) || (data[r*width+i*8+6] > maxvalue/2)) ? 0x00 : 0x02) | \
-					(((i*8+7 >= width) || (data[r*width+i*8+7] > maxvalue/2)) ? 0x00 : 0x01);
+			const pnm_data_t *row = data + r*width;
+			for (int i = 0; i < row_bytes; i++) {
+				pnm_data_t byte = 0;
+				for (int bit = 0; (bit < 8) && (i*8 + bit < width); bit++)
+					byte |= (row[i*8 + bit] ? 0x80 : 0x00) >> bit;
+				dest.data[r*row_bytes + i] = byte;
 			}
 		}
 	}
-	else if (((convert_type&3) == (int)pnm_variant_type::ascii_ppm) && (dest.type == pnm_variant_type::binary_pbm)) { // Convert (ascii/binary) color image to binary bitmap image
-		for (int r = 0; r < height; r++) {
-			for (int i = 0; i <= (width - 1)/8; i++) {
-				dest.data[r*((width-1)/8+1) + i] = \
-					(((i*8+0 >= width) || (data[(r*width+i*8+0)*3+0] + data[(r*width+i*8+0)*3+1] + data[(r*width+i*8+0)*3+2] > maxvalue*3/2)) ? 0x00 : 0x80) | \
-					(((i*8+1 >= width) || (data[(r*width+i*8+1)*3+0] + data[(r*width+i*8+1)*3+1] + data[(r*width+i*8+1)*3+2] > maxvalue*3/2)) ? 0x00 : 0x40) | \
-					(((i*8+2 >= width) || (data[(r*width+i*8+2)*3+0] + data[(r*width+i*8+2)*3+1] + data[(r*width+i*8+2)*3+2] > maxvalue*3/2)) ? 0x00 : 0x20) | \
-					(((i*8+3 >= width) || (data[(r*width+i*8+3)*3+0] + data[(r*width+i*8+3)*3+1] + data[(r*width+i*8+3)*3+2] > maxvalue*3/2)) ? 0x00 : 0x10) | \
-					(((i*8+4 >= width) || (data[(r*width+i*8+4)*3+0] + data[(r*width+i*8+4)*3+1] + data[(r*width+i*8+4)*3+2] > maxvalue*3/2)) ? 0x00 : 0x08) | \
-					(((i*8+5 >= width) || (data[(r*width+i*8+5)*3+0] + data[(r*width+i*8+5)*3+1] + data[(r*width+i*8+5)*3+2] > maxvalue*3/2)) ? 0x00 : 0x04) | \
-					(((i*8+6 >= width) || (data[(r*width+i*8+6)*3+0] + data[(r*width+i*8+6)*3+1] + data[(r*width+i*8+6)*3+2] > maxvalue*3/2)) ? 0x00 : 0x02) | \
-					(((i*8+7 >= width) || (data[(r*width+i*8+7)*3+0] + data[(r*width+i*8+7)*3+1] + data[(r*width+i*8+7)*3+2] > maxvalue*3/2)) ? 0x00 : 0x01);
-			}
-		}
+	else if (((convert_type&3) == (int)pnm_variant_type::ascii_pgm) && (dest.type == pnm_variant_type::binary_pbm)) { // Convert (ascii/binary) grayscale to binary bitmap image
+		for (int r = 0; r < height; r++)
+			pnm_kernels::pack_bits(data + r*width, dest.data + r*row_bytes, width, maxvalue/2);
 	}
-	else if (type == pnm_variant_type::binary_pbm) { // Unpacking of binary PGM images is unimplemented (well, this is realy unusual format)
-		log.log<log_level::error>("Conversion from binary PBM is not implemented.\n");
-		throw std::invalid_argument("Conversion from binary PBM is not implemented.");
+	else if (((convert_type&3) == (int)pnm_variant_type::ascii_ppm) && (dest.type == pnm_variant_type::binary_pbm)) { // Convert (ascii/binary) color image to binary bitmap image
+		for (int r = 0; r < height; r++)
+			pnm_kernels::pack_rgb_bits(data + r*width*3, dest.data + r*row_bytes, width, maxvalue*3/2);
 	}
 	else {
 		switch (convert_type) {
 			case ((int)pnm_variant_type::ascii_pgm << 4) | (int)pnm_variant_type::ascii_pgm: // Same type to same type, only change binary to ascii or vice versa
 			case ((int)pnm_variant_type::ascii_ppm << 4) | (int)pnm_variant_type::ascii_ppm:
 				std::swap(dest.data, data); // Move data, keep format
+				std::swap(dest.owns_data, owns_data);
+				std::swap(dest.mapping, mapping);
 				break;
 			case ((int)pnm_variant_type::ascii_pgm << 4) | (int)pnm_variant_type::ascii_pbm: // Scale up from bitmap to grayscale
 				for (int i = 0; i < new_size; i++)
@@ -185,19 +389,14 @@ void pnm_image::convert(pnm_variant_type new_type) {
 					dest.data[i] = (data[i] >= 128) ? 0 : 1;
 				break;
 			case ((int)pnm_variant_type::ascii_ppm << 4) | (int)pnm_variant_type::ascii_pgm: // Copy from grayscale to color
-				for (int i = 0; i < new_size; i+=3) {
-					dest.data[i+0] = data[i/3];
-					dest.data[i+1] = data[i/3];
-					dest.data[i+2] = data[i/3];
-				}
+				pnm_kernels::gray_to_rgb(data, dest.data, new_size / 3);
 				break;
 			case ((int)pnm_variant_type::ascii_pbm << 4) | (int)pnm_variant_type::ascii_ppm: // Threshold from color to bitmap
 				for (int i = 0; i < new_size; i++)
 					dest.data[i] = (data[i*3] + data[i*3 + 1] + data[i*3 + 2] >= 128*3) ? 0 : 1;
 				break;
 			case ((int)pnm_variant_type::ascii_pgm << 4) | (int)pnm_variant_type::ascii_ppm: // Average from color to grayscale
-				for (int i = 0; i < new_size; i++)
-					dest.data[i] = (data[i*3] + data[i*3 + 1] + data[i*3 + 2]) / 3;
+				pnm_kernels::rgb_to_gray(data, dest.data, new_size);
 				break;
 			default:
 				log.log<log_level::error>("Unknown conversion types (from %i, to %i).\n", type, dest.type); // This is not going to happen if datastructures are ok
@@ -208,33 +407,40 @@ void pnm_image::convert(pnm_variant_type new_type) {
 }
 
 pnm_image::~pnm_image() {
-	if (data) // Non-empty image
+	drop_data();
+}
+
+void pnm_image::drop_data() {
+	if (data && owns_data) // Non-empty image with our own buffer
 		delete[] data;
+	data = NULL;
+	owns_data = true;
+	mapping.reset();
 }
 
 void pnm_image::erase_image() {
 	std::memset(data, 255, size()*sizeof(pnm_data_t)); // Set everything to white
 }
 
-int pnm_image::size() { // Calculate size for image storing
-	int size = 0;
+size_t pnm_image::size() { // Calculate size for image storing, dimensions are checked by set_header
+	size_t size = 0;
 	switch (type) {
 		case pnm_variant_type::ascii_pbm: // bitmap (black/white)
-			size = width * height;
+			size = (size_t) width * height;
 			break;
 		case pnm_variant_type::binary_pbm: // bitmap (black/white)
-			size = ((width - 1) / 8 + 1) * height; // Binary PBM images has 8 pixels packed in one byte. Bits at the end of each row are unused
+			size = (size_t) ((width - 1) / 8 + 1) * height; // Binary PBM images has 8 pixels packed in one byte. Bits at the end of each row are unused
 			break;
 		case pnm_variant_type::ascii_pgm: // grayscale
 		case pnm_variant_type::binary_pgm: // grayscale
-			size = width * height;
+			size = (size_t) width * height;
 			break;
 		case pnm_variant_type::ascii_ppm: // RGB
 		case pnm_variant_type::binary_ppm: // RGB
-			size = width * height * 3;
+			size = (size_t) width * height * 3;
 			break;
 	}
-	log.log<log_level::debug>("PNM size = %i\n", size);
+	log.log<log_level::debug>("PNM size = %zu\n", size);
 	return size;
 }
 
@@ -256,11 +462,18 @@ pnm_image &pnm_image::operator=(pnm_image &&move) { // Move image
 	height = move.height;
 	type = move.type;
 	maxvalue = move.maxvalue;
-	if (data)
-		delete[] data;
+	drop_data();
 	data = move.data;
+	owns_data = move.owns_data;
+	mapping = std::move(move.mapping);
 	move.data = NULL;
+	move.owns_data = true;
 	return *this;
 }
 
+pnm_image::pnm_image(pnm_image &&move): width(move.width), height(move.height), type(move.type), maxvalue(move.maxvalue), data(move.data), owns_data(move.owns_data), mapping(std::move(move.mapping)), log(move.log), par(move.par) { // Move image
+	move.data = NULL;
+	move.owns_data = true;
+}
+
 }; // namespace
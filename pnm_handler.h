@@ -9,6 +9,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <memory>
 #include "logger.h"
 #include "config.h"
 #include "parameters.h"
@@ -28,7 +29,7 @@ enum class pnm_variant_type {
 
 class pnm_image {
 public:
-	pnm_image(parameters &params): width(0), height(0), type(pnm_variant_type::ascii_pbm), maxvalue(1), data(NULL), par(&params) {
+	pnm_image(parameters &params): width(0), height(0), type(pnm_variant_type::ascii_pbm), maxvalue(1), data(NULL), owns_data(true), par(&params) {
 		int *param_pnm_verbosity;
 		par->bind_param(param_pnm_verbosity, "pnm_verbosity", 0);
 		log.set_verbosity((log_level) *param_pnm_verbosity);
@@ -40,12 +41,14 @@ public:
 		maxvalue = guess_maxvalue();
 		data = new pnm_data_t[size()];
 	};
-	pnm_image(const pnm_image & copy): width(copy.width), height(copy.height), type(copy.type), maxvalue(copy.maxvalue), log(copy.log), par(copy.par) { // copy constructor
+	pnm_image(const pnm_image & copy): width(copy.width), height(copy.height), type(copy.type), maxvalue(copy.maxvalue), owns_data(true), log(copy.log), par(copy.par) { // copy constructor
 		data = new pnm_data_t[size()];
 		std::memcpy(data, copy.data, sizeof(pnm_data_t) * size());
 	};
 	~pnm_image();
-	void read(FILE *fd);
+	void read(FILE *fd); // Regular files are mapped to memory (binary data are not copied), other streams are read in bulk
+	void read_info(FILE *fd); // Read only header, image data are left in stream (and data pointer is empty)
+	void map(const void *buffer, size_t length); // Use binary image from memory without copying, buffer has to outlive the image
 	void write(FILE *fd);
 	void convert(pnm_variant_type new_type); // Convert between two image types
 	void erase_image(); // Fill image with white
@@ -54,13 +57,19 @@ public:
 	pnm_variant_type type;
 	pnm_data_t maxvalue; // Maximal value of one pixel
 	pnm_data_t *data; // Raw data
-	pnm_image(pnm_image &&) = default;
+	pnm_image(pnm_image &&move);
 	pnm_image &operator=(pnm_image &&move);
 private:
-	int fscanf_comment(FILE *stream, const char *format, ...); // Read line from filedescriptor, ignore comments (#)
-	bool read_header(FILE *fd); // Parse header
+	bool owns_data; // False if data points to foreign buffer (see map) or to mapped file
+	std::shared_ptr<void> mapping; // Mapped input file, unmapped with last image using it
+	void drop_data(); // Free data (if they are ours)
+	bool read_header(const pnm_data_t *&pos, const pnm_data_t *end); // Parse header from memory
+	bool read_header(FILE *fd); // Parse header from stream, stops at first byte of data
+	bool set_header(char ntype, int max); // Validate and store parsed header, clear old data
+	bool read_mapped(FILE *fd); // Read image by mmap, false if file can not be mapped
+	void read_ascii_data(const pnm_data_t *&pos, const pnm_data_t *end); // Parse ASCII image data from memory
 	void write_header(FILE *fd); // Write image header
-	int size(); // Calculate buffersize for new data (given type and image dimensions)
+	size_t size(); // Calculate buffersize for new data (given type and image dimensions)
 	int guess_maxvalue(); // Get common maxvalue for image type (1 for bitmap, 255 for others)
 
 	logger log;
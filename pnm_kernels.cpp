@@ -0,0 +1,344 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdint>
+#include <cstring>
+#include "pnm_kernels.h"
+#if defined(__x86_64__) || defined(__i386__)
+#define VECTORIX_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+// Pixel kernels for conversions of PNM data
+//
+// SIMD versions are compiled with target attributes, so the rest of program
+// does not need any special compiler flags. All versions give identical output.
+
+namespace vectorix {
+
+namespace pnm_kernels {
+
+/*
+ * Tables
+ */
+
+class bit_table { // Byte of bitmap -> 8 bytes with 0xFF for set bits (first pixel in lowest address)
+public:
+	bit_table() {
+		for (int b = 0; b < 256; b++) {
+			uint8_t bytes[8];
+			for (int i = 0; i < 8; i++)
+				bytes[i] = (b & (0x80 >> i)) ? 0xFF : 0x00;
+			std::memcpy(&mask[b], bytes, 8);
+			reverse[b] = 0;
+			for (int i = 0; i < 8; i++)
+				reverse[b] |= ((b >> i) & 1) << (7 - i);
+		}
+	};
+	uint64_t mask[256];
+	uint8_t reverse[256]; // Bit order reversed (movemask has first pixel in lowest bit, PBM in highest)
+};
+
+static const bit_table table;
+
+/*
+ * Scalar versions (also used for ends of rows)
+ */
+
+static void unpack_bits_scalar(const uint8_t *in, uint8_t *out, int width, uint8_t one, uint8_t zero) {
+	const uint64_t ones = 0x0101010101010101ull * one; // Value repeated in all bytes
+	const uint64_t zeros = 0x0101010101010101ull * zero;
+	int i = 0;
+	for (; i + 8 <= width; i += 8) { // Whole bytes, 8 pixels at once
+		uint64_t m = table.mask[*in++];
+		uint64_t pixels = (ones & m) | (zeros & ~m);
+		std::memcpy(out + i, &pixels, 8);
+	}
+	for (int bit = 0; i < width; i++, bit++) // Rest of last byte (padding bits are ignored)
+		out[i] = (*in & (0x80 >> bit)) ? one : zero;
+}
+
+static void pack_bits_scalar(const uint8_t *in, uint8_t *out, int width, uint8_t threshold) {
+	for (int i = 0; i < width; i += 8) {
+		uint8_t byte = 0;
+		for (int bit = 0; (bit < 8) && (i + bit < width); bit++)
+			byte |= (in[i + bit] <= threshold) << (7 - bit);
+		*out++ = byte;
+	}
+}
+
+static void pack_rgb_bits_scalar(const uint8_t *in, uint8_t *out, int width, int threshold) {
+	for (int i = 0; i < width; i += 8) {
+		uint8_t byte = 0;
+		for (int bit = 0; (bit < 8) && (i + bit < width); bit++, in += 3)
+			byte |= (in[0] + in[1] + in[2] <= threshold) << (7 - bit);
+		*out++ = byte;
+	}
+}
+
+static void rgb_to_gray_scalar(const uint8_t *in, uint8_t *out, int pixels) {
+	for (int i = 0; i < pixels; i++, in += 3)
+		out[i] = (in[0] + in[1] + in[2]) / 3;
+}
+
+static void gray_to_rgb_scalar(const uint8_t *in, uint8_t *out, int pixels) {
+	for (int i = 0; i < pixels; i++, out += 3)
+		out[0] = out[1] = out[2] = in[i];
+}
+
+#ifdef VECTORIX_KERNELS_X86
+
+/*
+ * SSE2
+ */
+
+__attribute__((target("sse2")))
+static void unpack_bits_sse2(const uint8_t *in, uint8_t *out, int width, uint8_t one, uint8_t zero) {
+	const __m128i bits = _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+	const __m128i ones = _mm_set1_epi8(one);
+	const __m128i zeros = _mm_set1_epi8(zero);
+	int i = 0;
+	for (; i + 16 <= width; i += 16, in += 2) {
+		__m128i v = _mm_cvtsi32_si128(in[0] | (in[1] << 8));
+		v = _mm_unpacklo_epi8(v, v); // b0 b0 b1 b1
+		v = _mm_unpacklo_epi16(v, v); // b0 x4, b1 x4
+		v = _mm_unpacklo_epi32(v, v); // b0 x8, b1 x8
+		__m128i m = _mm_cmpeq_epi8(_mm_and_si128(v, bits), bits);
+		_mm_storeu_si128((__m128i *) (out + i), _mm_or_si128(_mm_and_si128(m, ones), _mm_andnot_si128(m, zeros)));
+	}
+	if (i < width)
+		unpack_bits_scalar(in, out + i, width - i, one, zero);
+}
+
+__attribute__((target("sse2")))
+static void pack_bits_sse2(const uint8_t *in, uint8_t *out, int width, uint8_t threshold) {
+	int i = 0;
+	if (threshold < 255) {
+		const __m128i above = _mm_set1_epi8(threshold + 1);
+		for (; i + 16 <= width; i += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+			int white = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, above), v)); // v > threshold
+			*out++ = table.reverse[~white & 0xFF];
+			*out++ = table.reverse[(~white >> 8) & 0xFF];
+		}
+	}
+	if (i < width)
+		pack_bits_scalar(in + i, out, width - i, threshold);
+}
+
+/*
+ * SSSE3 (RGB data need byte shuffles)
+ */
+
+__attribute__((target("ssse3")))
+static inline void rgb_sums_ssse3(const uint8_t *in, __m128i &lo, __m128i &hi) { // r + g + b of 16 pixels as 16bit numbers
+	__m128i a = _mm_loadu_si128((const __m128i *) (in + 0));
+	__m128i b = _mm_loadu_si128((const __m128i *) (in + 16));
+	__m128i c = _mm_loadu_si128((const __m128i *) (in + 32));
+	__m128i r = _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+		_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+	__m128i g = _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+		_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+	__m128i bl = _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+		_mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+	const __m128i z = _mm_setzero_si128();
+	lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(r, z), _mm_unpacklo_epi8(g, z)), _mm_unpacklo_epi8(bl, z));
+	hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(r, z), _mm_unpackhi_epi8(g, z)), _mm_unpackhi_epi8(bl, z));
+}
+
+__attribute__((target("ssse3")))
+static void rgb_to_gray_ssse3(const uint8_t *in, uint8_t *out, int pixels) {
+	const __m128i third = _mm_set1_epi16((short) 43691); // x / 3 == (x * 43691) >> 17 for x <= 765
+	int i = 0;
+	for (; i + 16 <= pixels; i += 16, in += 48) {
+		__m128i lo, hi;
+		rgb_sums_ssse3(in, lo, hi);
+		lo = _mm_srli_epi16(_mm_mulhi_epu16(lo, third), 1);
+		hi = _mm_srli_epi16(_mm_mulhi_epu16(hi, third), 1);
+		_mm_storeu_si128((__m128i *) (out + i), _mm_packus_epi16(lo, hi));
+	}
+	if (i < pixels)
+		rgb_to_gray_scalar(in, out + i, pixels - i);
+}
+
+__attribute__((target("ssse3")))
+static void pack_rgb_bits_ssse3(const uint8_t *in, uint8_t *out, int width, int threshold) {
+	int i = 0;
+	if (threshold < 765) {
+		const __m128i limit = _mm_set1_epi16(threshold);
+		for (; i + 16 <= width; i += 16, in += 48) {
+			__m128i lo, hi;
+			rgb_sums_ssse3(in, lo, hi);
+			__m128i above = _mm_packs_epi16(_mm_cmpgt_epi16(lo, limit), _mm_cmpgt_epi16(hi, limit));
+			int white = _mm_movemask_epi8(above);
+			*out++ = table.reverse[~white & 0xFF];
+			*out++ = table.reverse[(~white >> 8) & 0xFF];
+		}
+	}
+	if (i < width)
+		pack_rgb_bits_scalar(in, out, width - i, threshold);
+}
+
+__attribute__((target("ssse3")))
+static void gray_to_rgb_ssse3(const uint8_t *in, uint8_t *out, int pixels) {
+	const __m128i s0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+	const __m128i s1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+	const __m128i s2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+	int i = 0;
+	for (; i + 16 <= pixels; i += 16, out += 48) {
+		__m128i v = _mm_loadu_si128((const __m128i *) (in + i));
+		_mm_storeu_si128((__m128i *) (out + 0), _mm_shuffle_epi8(v, s0));
+		_mm_storeu_si128((__m128i *) (out + 16), _mm_shuffle_epi8(v, s1));
+		_mm_storeu_si128((__m128i *) (out + 32), _mm_shuffle_epi8(v, s2));
+	}
+	if (i < pixels)
+		gray_to_rgb_scalar(in + i, out, pixels - i);
+}
+
+/*
+ * AVX2
+ */
+
+__attribute__((target("avx2")))
+static void unpack_bits_avx2(const uint8_t *in, uint8_t *out, int width, uint8_t one, uint8_t zero) {
+	const __m256i spread = _mm256_setr_epi8( // Byte k of input to pixels 8k..8k+7 (lanes have the same input)
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+		2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+	const __m256i bits = _mm256_set1_epi64x(0x0102040810204080ll);
+	const __m256i ones = _mm256_set1_epi8(one);
+	const __m256i zeros = _mm256_set1_epi8(zero);
+	int i = 0;
+	for (; i + 32 <= width; i += 32, in += 4) {
+		int32_t word;
+		std::memcpy(&word, in, 4);
+		__m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32(word), spread);
+		__m256i m = _mm256_cmpeq_epi8(_mm256_and_si256(v, bits), bits);
+		_mm256_storeu_si256((__m256i *) (out + i), _mm256_blendv_epi8(zeros, ones, m));
+	}
+	if (i < width)
+		unpack_bits_sse2(in, out + i, width - i, one, zero);
+}
+
+__attribute__((target("avx2")))
+static void pack_bits_avx2(const uint8_t *in, uint8_t *out, int width, uint8_t threshold) {
+	int i = 0;
+	if (threshold < 255) {
+		const __m256i above = _mm256_set1_epi8(threshold + 1);
+		for (; i + 32 <= width; i += 32) {
+			__m256i v = _mm256_loadu_si256((const __m256i *) (in + i));
+			uint32_t black = ~(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v, above), v));
+			*out++ = table.reverse[black & 0xFF];
+			*out++ = table.reverse[(black >> 8) & 0xFF];
+			*out++ = table.reverse[(black >> 16) & 0xFF];
+			*out++ = table.reverse[black >> 24];
+		}
+	}
+	if (i < width)
+		pack_bits_sse2(in + i, out, width - i, threshold);
+}
+
+#endif
+
+/*
+ * Runtime dispatch
+ */
+
+class kernel_table {
+public:
+	void (*unpack_bits)(const uint8_t *, uint8_t *, int, uint8_t, uint8_t);
+	void (*pack_bits)(const uint8_t *, uint8_t *, int, uint8_t);
+	void (*pack_rgb_bits)(const uint8_t *, uint8_t *, int, int);
+	void (*rgb_to_gray)(const uint8_t *, uint8_t *, int);
+	void (*gray_to_rgb)(const uint8_t *, uint8_t *, int);
+	simd_level level;
+};
+
+static kernel_table make_table(simd_level l) {
+	kernel_table t = {unpack_bits_scalar, pack_bits_scalar, pack_rgb_bits_scalar, rgb_to_gray_scalar, gray_to_rgb_scalar, simd_level::scalar};
+#ifdef VECTORIX_KERNELS_X86
+	if (l >= simd_level::sse2) {
+		t.unpack_bits = unpack_bits_sse2;
+		t.pack_bits = pack_bits_sse2;
+	}
+	if (l >= simd_level::ssse3) {
+		t.pack_rgb_bits = pack_rgb_bits_ssse3;
+		t.rgb_to_gray = rgb_to_gray_ssse3;
+		t.gray_to_rgb = gray_to_rgb_ssse3;
+	}
+	if (l >= simd_level::avx2) {
+		t.unpack_bits = unpack_bits_avx2;
+		t.pack_bits = pack_bits_avx2;
+	}
+	t.level = l;
+#endif
+	return t;
+}
+
+simd_level detected_level() {
+#ifdef VECTORIX_KERNELS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return simd_level::avx2;
+	if (__builtin_cpu_supports("ssse3"))
+		return simd_level::ssse3;
+	if (__builtin_cpu_supports("sse2"))
+		return simd_level::sse2;
+#endif
+	return simd_level::scalar;
+}
+
+static kernel_table active = make_table(detected_level());
+
+simd_level level() {
+	return active.level;
+}
+
+void set_level(simd_level l) {
+	if (l > detected_level())
+		l = detected_level();
+	active = make_table(l);
+}
+
+const char *level_name(simd_level l) {
+	switch (l) {
+		case simd_level::sse2:
+			return "sse2";
+		case simd_level::ssse3:
+			return "ssse3";
+		case simd_level::avx2:
+			return "avx2";
+		default:
+			return "scalar";
+	}
+}
+
+void unpack_bits(const uint8_t *in, uint8_t *out, int width, uint8_t one, uint8_t zero) {
+	active.unpack_bits(in, out, width, one, zero);
+}
+
+void pack_bits(const uint8_t *in, uint8_t *out, int width, uint8_t threshold) {
+	active.pack_bits(in, out, width, threshold);
+}
+
+void pack_rgb_bits(const uint8_t *in, uint8_t *out, int width, int threshold) {
+	active.pack_rgb_bits(in, out, width, threshold);
+}
+
+void rgb_to_gray(const uint8_t *in, uint8_t *out, int pixels) {
+	active.rgb_to_gray(in, out, pixels);
+}
+
+void gray_to_rgb(const uint8_t *in, uint8_t *out, int pixels) {
+	active.gray_to_rgb(in, out, pixels);
+}
+
+}; // namespace
+
+}; // namespace
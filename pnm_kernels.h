@@ -0,0 +1,46 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__PNM_KERNELS_H
+#define VECTORIX__PNM_KERNELS_H
+
+// Pixel kernels for conversions of PNM data (one row at a time)
+//
+// Every kernel has scalar version and SIMD versions (x86: SSE2, SSSE3, AVX2),
+// the best one supported by CPU is selected at runtime.
+
+#include <cstdint>
+
+namespace vectorix {
+
+namespace pnm_kernels {
+
+enum class simd_level {
+	scalar = 0,
+	sse2 = 1,
+	ssse3 = 2,
+	avx2 = 3
+};
+
+simd_level detected_level(); // Best level supported by this CPU
+simd_level level(); // Level used by kernels
+void set_level(simd_level l); // Use lower level (benchmarks, tests), higher than detected is ignored
+const char *level_name(simd_level l);
+
+// Unpack one row of binary PBM (8 pixels per byte, MSB first): bit 1 -> one, bit 0 -> zero
+void unpack_bits(const uint8_t *in, uint8_t *out, int width, uint8_t one, uint8_t zero);
+// Pack one row of gray pixels to binary PBM: value <= threshold -> bit 1 (black), padding bits are 0
+void pack_bits(const uint8_t *in, uint8_t *out, int width, uint8_t threshold);
+// Pack one row of RGB pixels to binary PBM: r + g + b <= threshold -> bit 1 (black)
+void pack_rgb_bits(const uint8_t *in, uint8_t *out, int width, int threshold);
+// Average of channels: (r + g + b) / 3
+void rgb_to_gray(const uint8_t *in, uint8_t *out, int pixels);
+// Copy gray value to all three channels
+void gray_to_rgb(const uint8_t *in, uint8_t *out, int pixels);
+
+}; // namespace
+
+}; // namespace
+
+#endif
@@ -0,0 +1,623 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+
+// Quality and performance regression harness
+//
+// Usage: ./vectorix_regression config [update]
+// Every image from corpus is vectorized in its own process (to measure peak
+// RSS of one image). Vector output is rendered by renderer and compared with
+// thresholded input (IoU) and with golden output stored by previous update
+// run (IoU of renders, Chamfer and Hausdorff distance of sampled curves).
+// Run fails if any image drifts past configured thresholds. Images without
+// golden output are skipped (and reported). Time and peak RSS are compared
+// only with baseline measured on the same host. Every image is vectorized
+// once more in tiles and compared with the first output (tiling tolerance).
+// Before the corpus, distance skeleton of straight bars is checked to be one
+// pixel wide.
+//
+// Corpus file: one image per line, "synthetic <seed>" for generated strokes
+// or "drawing <seed>" for generated scan of pen drawing.
+
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <limits>
+#include <exception>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "v_image.h"
+#include "geom.h"
+#include "pnm_handler.h"
+#include "parameters.h"
+#include "render.h"
+#include "job.h"
+#include "thresholder.h"
+#include "skeletonizer.h"
+#include "timer.h"
+
+using namespace vectorix;
+
+class regression_params {
+public:
+	std::string *corpus;
+	std::string *golden_dir;
+	p *min_input_iou;
+	p *min_golden_iou;
+	p *max_chamfer;
+	p *max_hausdorff;
+	p *max_time_ratio;
+	p *max_rss_ratio;
+	int *tile_size;
+	p *min_tiled_iou;
+	p *max_tiled_chamfer;
+	void bind(parameters &par) {
+		par.add_comment("Regression harness: list of images (\"synthetic <seed>\" and \"drawing <seed>\" for generated ones)");
+		par.bind_param(corpus, "regression_corpus", (std::string) "regression/corpus");
+		par.add_comment("Regression harness: directory with golden outputs (and generated images)");
+		par.bind_param(golden_dir, "regression_golden_dir", (std::string) "regression/golden");
+		par.add_comment("Regression harness: minimal IoU of rendered output and thresholded input");
+		par.bind_param(min_input_iou, "regression_min_input_iou", (p) 0.5);
+		par.add_comment("Regression harness: minimal IoU of rendered output and golden render");
+		par.bind_param(min_golden_iou, "regression_min_golden_iou", (p) 0.95);
+		par.add_comment("Regression harness: maximal mean (Chamfer) and maximal (Hausdorff) distance of curves from golden ones in pixels");
+		par.bind_param(max_chamfer, "regression_max_chamfer", (p) 0.5);
+		par.bind_param(max_hausdorff, "regression_max_hausdorff", (p) 4);
+		par.add_comment("Regression harness: maximal ratio of time and peak memory to baseline run on this host, 0 = no check");
+		par.bind_param(max_time_ratio, "regression_max_time_ratio", (p) 1.5);
+		par.bind_param(max_rss_ratio, "regression_max_rss_ratio", (p) 1.3);
+		par.add_comment("Regression harness: tile size of second (tiled) run of every image, 0 = no tiled run");
+		par.bind_param(tile_size, "regression_tile_size", 128);
+		par.add_comment("Regression harness: minimal IoU of renders and maximal Chamfer distance of curves of tiled and untiled output");
+		par.bind_param(min_tiled_iou, "regression_min_tiled_iou", (p) 0.9);
+		par.bind_param(max_tiled_chamfer, "regression_max_tiled_chamfer", (p) 1);
+	};
+};
+
+class result { // Measured in child process
+public:
+	bool ok = false;
+	double time = 0; // Vectorization time (in seconds)
+	long rss = 0; // Peak RSS (in KiB)
+	double input_iou = 0;
+	bool has_golden = false;
+	bool has_baseline = false; // Time and RSS of update run on this host
+	double golden_time = 0;
+	long golden_rss = 0;
+	double golden_iou = 0;
+	double chamfer = 0;
+	double hausdorff = 0;
+	bool has_tiled = false;
+	double tiled_iou = 0;
+	double tiled_chamfer = 0;
+};
+
+/*
+ * Synthetic corpus
+ */
+
+static std::string synthetic_image(int seed, const std::string &dir) { // Random strokes, arcs and dots
+	std::string name = dir + "/synthetic_" + std::to_string(seed) + ".png";
+	std::mt19937 rng(seed);
+	cv::Mat img(512, 512, CV_8UC3, cv::Scalar(255, 255, 255));
+	for (int i = 0; i < 24; i++) {
+		cv::Point a(rng() % 512, rng() % 512);
+		cv::Point b(rng() % 512, rng() % 512);
+		int thickness = 1 + rng() % 8;
+		switch (rng() % 3) {
+			case 0:
+				cv::line(img, a, b, cv::Scalar(0, 0, 0), thickness);
+				break;
+			case 1:
+				cv::ellipse(img, a, cv::Size(10 + rng() % 80, 10 + rng() % 80), rng() % 180, 0, 90 + rng() % 270, cv::Scalar(0, 0, 0), thickness);
+				break;
+			default:
+				cv::circle(img, a, 1 + rng() % 4, cv::Scalar(0, 0, 0), -1);
+		}
+	}
+	if (!cv::imwrite(name, img))
+		throw std::invalid_argument("Unable to write synthetic image.");
+	return name;
+}
+
+static std::string drawing_image(int seed, const std::string &dir) { // Pen strokes of varying width and hatching on noisy paper, blurred as by scanner
+	std::string name = dir + "/drawing_" + std::to_string(seed) + ".png";
+	std::mt19937 rng(seed);
+	std::normal_distribution<double> noise(0, 6);
+	cv::Mat img(640, 640, CV_8UC3, cv::Scalar(232, 236, 238));
+	cv::Scalar ink(40, 30, 25);
+	for (int i = 0; i < 12; i++) { // Strokes: quadratic curves, width changes with pen pressure
+		v_pt a(rng() % 640, rng() % 640), b(rng() % 640, rng() % 640), c(rng() % 640, rng() % 640);
+		double width = 1 + rng() % 5;
+		cv::Point last(a.x, a.y);
+		for (int s = 1; s <= 40; s++) {
+			double u = s / 40.;
+			v_pt pt = a * ((1 - u) * (1 - u)) + c * (2 * u * (1 - u)) + b * (u * u);
+			cv::Point next(std::lround(pt.x), std::lround(pt.y));
+			cv::line(img, last, next, ink, std::max(1, (int) std::lround(width * (0.6 + 0.8 * std::sin(u * M_PI)))), cv::LINE_AA);
+			last = next;
+		}
+	}
+	for (int i = 0; i < 3; i++) { // Hatching
+		int x = rng() % 540, y = rng() % 540;
+		for (int k = 0; k < 12; k++)
+			cv::line(img, cv::Point(x + k * 8, y), cv::Point(x + k * 8 + 30, y + 80), ink, 1, cv::LINE_AA);
+	}
+	for (int i = 0; i < img.rows; i++) {
+		cv::Vec3b *row = img.ptr<cv::Vec3b>(i);
+		for (int j = 0; j < img.cols; j++) {
+			int n = noise(rng);
+			for (int ch = 0; ch < 3; ch++)
+				row[j][ch] = cv::saturate_cast<uint8_t>(row[j][ch] + n);
+		}
+	}
+	cv::GaussianBlur(img, img, cv::Size(3, 3), 0.8);
+	if (!cv::imwrite(name, img))
+		throw std::invalid_argument("Unable to write generated drawing.");
+	return name;
+}
+
+/*
+ * Comparison
+ */
+
+static void sample_curves(const v_image &img, std::vector<v_pt> &points) { // Points on curves, at most 0.5 px apart
+	for (const v_line &line: img.line) {
+		auto two = line.segment.cbegin();
+		if (two == line.segment.cend())
+			continue;
+		auto one = two++;
+		if (two == line.segment.cend())
+			points.push_back(one->main);
+		for (; two != line.segment.cend(); one = two++) {
+			int steps = std::ceil(geom::bezier_maximal_length(*one, *two) * 2) + 1;
+			for (int s = 0; s <= steps; s++) {
+				p u = s / (p) steps;
+				p v = 1 - u;
+				points.push_back(one->main * (v*v*v) + one->control_next * (3*v*v*u) + two->control_prev * (3*v*u*u) + two->main * (u*u*u));
+			}
+		}
+	}
+}
+
+static void directed_distance(const std::vector<v_pt> &from, const std::vector<v_pt> &to, int width, int height, double &mean, double &max) {
+	// Distance transform of raster with target points, lookup for every source point
+	cv::Mat raster(height, width, CV_8UC1, cv::Scalar(255));
+	for (const v_pt &pt: to) {
+		int x = std::min(std::max((int) pt.x, 0), width - 1);
+		int y = std::min(std::max((int) pt.y, 0), height - 1);
+		raster.at<uint8_t>(y, x) = 0;
+	}
+	cv::Mat dist;
+	cv::distanceTransform(raster, dist, CV_DIST_L2, 3);
+	mean = max = 0;
+	for (const v_pt &pt: from) {
+		int x = std::min(std::max((int) pt.x, 0), width - 1);
+		int y = std::min(std::max((int) pt.y, 0), height - 1);
+		double d = dist.at<float>(y, x);
+		mean += d;
+		max = std::max(max, d);
+	}
+	if (!from.empty())
+		mean /= from.size();
+}
+
+static void curve_distance(const std::vector<v_pt> &a, const std::vector<v_pt> &b, int width, int height, double &chamfer, double &hausdorff) {
+	if (a.empty() || b.empty()) {
+		chamfer = hausdorff = (a.empty() && b.empty()) ? 0 : std::numeric_limits<double>::infinity();
+		return;
+	}
+	double mean_ab, max_ab, mean_ba, max_ba;
+	directed_distance(a, b, width, height, mean_ab, max_ab);
+	directed_distance(b, a, width, height, mean_ba, max_ba);
+	chamfer = (mean_ab + mean_ba) / 2;
+	hausdorff = std::max(max_ab, max_ba);
+}
+
+template <typename F, typename G>
+static double iou(int width, int height, F a, G b) { // Intersection over union of two pixel sets
+	long intersection = 0, sum = 0;
+	for (int i = 0; i < height; i++) {
+		for (int j = 0; j < width; j++) {
+			intersection += a(i, j) && b(i, j);
+			sum += a(i, j) || b(i, j);
+		}
+	}
+	return sum ? (double) intersection / sum : 1.;
+}
+
+/*
+ * Golden files: <dir>/<name>.golden (sampled curves), <dir>/<name>.pgm (render)
+ * and <dir>/<name>.<host>.baseline (time and rss, comparable only on the same machine)
+ */
+
+static std::string golden_base(const std::string &dir, const std::string &name) {
+	std::string base = name.substr(name.rfind('/') + 1);
+	size_t dot = base.rfind('.');
+	if (dot != std::string::npos)
+		base = base.substr(0, dot);
+	return dir + "/" + base;
+}
+
+static std::string baseline_name(const std::string &base) {
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	return base + "." + host + ".baseline";
+}
+
+static bool read_baseline(const std::string &base, result &res) {
+	FILE *fd = fopen(baseline_name(base).c_str(), "r");
+	if (!fd)
+		return false;
+	bool ok = fscanf(fd, "%lf %li", &res.golden_time, &res.golden_rss) == 2;
+	fclose(fd);
+	return ok;
+}
+
+static bool read_golden(const std::string &base, parameters &par, result &res, std::vector<v_pt> &points, pnm_image &render) {
+	FILE *fd = fopen((base + ".golden").c_str(), "r");
+	if (!fd)
+		return false;
+	long count;
+	bool ok = fscanf(fd, "%li", &count) == 1;
+	for (long i = 0; ok && (i < count); i++) {
+		double x, y;
+		ok = fscanf(fd, "%lf %lf", &x, &y) == 2;
+		points.push_back(v_pt(x, y));
+	}
+	fclose(fd);
+	if (!ok || !(fd = fopen((base + ".pgm").c_str(), "r")))
+		return false;
+	render.read(fd);
+	fclose(fd);
+	return true;
+}
+
+static void write_golden(const std::string &base, const result &res, const std::vector<v_pt> &points, pnm_image &render) {
+	FILE *fd = fopen((base + ".golden").c_str(), "w");
+	if (!fd)
+		throw std::invalid_argument("Unable to write golden output.");
+	fprintf(fd, "%li\n", (long) points.size());
+	for (const v_pt &pt: points)
+		fprintf(fd, "%.3f %.3f\n", pt.x, pt.y);
+	fclose(fd);
+	if (!(fd = fopen((base + ".pgm").c_str(), "w")))
+		throw std::invalid_argument("Unable to write golden render.");
+	render.write(fd);
+	fclose(fd);
+	if (!(fd = fopen(baseline_name(base).c_str(), "w")))
+		throw std::invalid_argument("Unable to write baseline.");
+	fprintf(fd, "%f %li\n", res.time, res.rss);
+	fclose(fd);
+}
+
+/*
+ * One image (in child process)
+ */
+
+static void measure(const parameters &snapshot, const std::string &name, const std::string &golden, int tile_size, bool update, result &res) {
+	job j(snapshot);
+	j.load(name);
+	j.vectorize();
+	res.time = j.vectorization_time;
+
+	// Quality against input
+	cv::Mat orig = cv::imread(name, CV_LOAD_IMAGE_COLOR), binary;
+	if (!orig.data)
+		throw std::invalid_argument("Unable to read input image.");
+	thresholder thr(j.par);
+	thr.run(orig, binary);
+	renderer re(j.par);
+	pnm_image render = re.render(j.output);
+	res.input_iou = iou(render.width, render.height,
+		[&](int i, int k) { return !render.data[i * render.width + k]; },
+		[&](int i, int k) { return !!binary.at<uint8_t>(i, k); });
+
+	std::vector<v_pt> points;
+	sample_curves(j.output, points);
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	res.rss = usage.ru_maxrss; // Before tiled run
+
+	if (tile_size > 0) { // Same image in tiles, stitched output should match within tolerance
+		job tiled(snapshot);
+		int *param_tile_size;
+		tiled.par.bind_param(param_tile_size, "tile_size", 0);
+		*param_tile_size = tile_size;
+		tiled.load(name);
+		tiled.vectorize();
+		pnm_image tiled_render = re.render(tiled.output);
+		res.tiled_iou = iou(render.width, render.height,
+			[&](int i, int k) { return !render.data[i * render.width + k]; },
+			[&](int i, int k) { return !tiled_render.data[i * render.width + k]; });
+		std::vector<v_pt> tiled_points;
+		sample_curves(tiled.output, tiled_points);
+		double hausdorff;
+		curve_distance(points, tiled_points, render.width, render.height, res.tiled_chamfer, hausdorff);
+		res.has_tiled = true;
+	}
+
+	if (update)
+		write_golden(golden, res, points, render);
+	else {
+		std::vector<v_pt> golden_points;
+		pnm_image golden_render(j.par);
+		res.has_golden = read_golden(golden, j.par, res, golden_points, golden_render);
+		if (res.has_golden) {
+			if ((golden_render.width != render.width) || (golden_render.height != render.height))
+				throw std::invalid_argument("Golden render has different size.");
+			res.golden_iou = iou(render.width, render.height,
+				[&](int i, int k) { return !render.data[i * render.width + k]; },
+				[&](int i, int k) { return !golden_render.data[i * render.width + k]; });
+			curve_distance(points, golden_points, render.width, render.height, res.chamfer, res.hausdorff);
+			res.has_baseline = read_baseline(golden, res);
+		}
+	}
+	res.ok = true;
+}
+
+static bool run_isolated(const parameters &snapshot, const std::string &name, const std::string &golden, int tile_size, bool update, result &res, std::string &error) {
+	int pipefd[2];
+	if (pipe(pipefd))
+		return false;
+	fflush(NULL);
+	pid_t pid = fork();
+	if (pid < 0)
+		return false;
+	if (!pid) { // Child: measure and send result to parent
+		close(pipefd[0]);
+		result r;
+		std::string message;
+		try {
+			measure(snapshot, name, golden, tile_size, update, r);
+		}
+		catch (const std::exception &e) {
+			message = e.what();
+		}
+		catch (const char *e) {
+			message = e;
+		}
+		catch (...) {
+			message = "Unknown error.";
+		}
+		if (write(pipefd[1], &r, sizeof(r)) != sizeof(r))
+			_exit(2);
+		if (!message.empty() && (write(pipefd[1], message.data(), message.size()) < 0))
+			_exit(2);
+		_exit(0);
+	}
+	close(pipefd[1]);
+	bool ok = read(pipefd[0], &res, sizeof(res)) == sizeof(res);
+	char buffer[256];
+	ssize_t len;
+	while ((len = read(pipefd[0], buffer, sizeof(buffer))) > 0)
+		error.append(buffer, len);
+	close(pipefd[0]);
+	int status;
+	waitpid(pid, &status, 0);
+	if (!ok)
+		error = "Child process crashed.";
+	return ok && res.ok;
+}
+
+/*
+ * Skeleton checks
+ */
+
+static cv::Mat distance_skeleton(const parameters &snapshot, const cv::Mat &image) { // Skeleton by exact euclidean distance (skeletonization_type 5)
+	parameters par(snapshot);
+	int *type;
+	par.bind_param(type, "skeletonization_type", 4);
+	*type = 5;
+	skeletonizer ske(par);
+	cv::Mat skeleton, distance;
+	ske.run(image, skeleton, distance);
+	return skeleton;
+}
+
+static int skeleton_components(const cv::Mat &skeleton) { // Count of 8-connected components
+	cv::Mat seen = cv::Mat::zeros(skeleton.rows, skeleton.cols, CV_8UC1);
+	int components = 0;
+	std::vector<cv::Point> stack;
+	for (int i = 0; i < skeleton.rows; i++) {
+		for (int j = 0; j < skeleton.cols; j++) {
+			if (!skeleton.at<uint8_t>(i, j) || seen.at<uint8_t>(i, j))
+				continue;
+			components++;
+			seen.at<uint8_t>(i, j) = 1;
+			stack.push_back(cv::Point(j, i));
+			while (!stack.empty()) {
+				cv::Point p = stack.back();
+				stack.pop_back();
+				for (int y = std::max(0, p.y - 1); y <= std::min(skeleton.rows - 1, p.y + 1); y++) {
+					for (int x = std::max(0, p.x - 1); x <= std::min(skeleton.cols - 1, p.x + 1); x++) {
+						if (skeleton.at<uint8_t>(y, x) && !seen.at<uint8_t>(y, x)) {
+							seen.at<uint8_t>(y, x) = 1;
+							stack.push_back(cv::Point(x, y));
+						}
+					}
+				}
+			}
+		}
+	}
+	return components;
+}
+
+static bool skeleton_thin(const cv::Mat &skeleton, cv::Rect junction = cv::Rect()) { // No 2x2 block of skeleton pixels (except blocks starting in junction)
+	for (int i = 0; i + 1 < skeleton.rows; i++) {
+		for (int j = 0; j + 1 < skeleton.cols; j++) {
+			if (skeleton.at<uint8_t>(i, j) && skeleton.at<uint8_t>(i + 1, j) && skeleton.at<uint8_t>(i, j + 1) && skeleton.at<uint8_t>(i + 1, j + 1) && !junction.contains(cv::Point(j, i)))
+				return false;
+		}
+	}
+	return true;
+}
+
+static int check_skeleton_width(const parameters &snapshot) { // Distance skeleton of bars and discs is one pixel wide and connected, returns count of failures
+	int failed = 0;
+	auto check = [&](bool ok, const char *shape, double size, double angle) {
+		if (!ok) {
+			printf("Skeleton check: %s %g px wide at %g degrees is not one pixel wide line\n", shape, size, angle);
+			failed++;
+		}
+	};
+
+	// Axis-aligned bars of odd and even width, one pixel in every cross-section
+	int length = 40;
+	for (int vertical = 0; vertical < 2; vertical++) {
+		for (int width = 1; width <= 8; width++) {
+			cv::Mat bar = cv::Mat::zeros(vertical ? length + 10 : width + 10, vertical ? width + 10 : length + 10, CV_8UC1);
+			cv::Mat stroke = bar(vertical ? cv::Rect(5, 5, width, length) : cv::Rect(5, 5, length, width));
+			stroke = cv::Scalar(255);
+			cv::Mat skeleton = distance_skeleton(snapshot, bar);
+			bool ok = (skeleton_components(skeleton) == 1);
+			for (int k = 5 + width; k < 5 + length - width; k++) // Cross-sections away from ends
+				ok = ok && (cv::countNonZero(vertical ? skeleton.row(k) : skeleton.col(k)) == 1);
+			check(ok, "bar", width, vertical ? 90 : 0);
+		}
+	}
+
+	// Slanted bars (diagonal included), no 2x2 blocks
+	int size = 100;
+	for (int angle = 0; angle < 180; angle += 15) {
+		for (double width: {3., 6., 9., 12., 16.}) {
+			double dx = std::cos(angle * M_PI / 180);
+			double dy = std::sin(angle * M_PI / 180);
+			cv::Mat bar = cv::Mat::zeros(size, size, CV_8UC1);
+			for (int i = 0; i < size; i++) {
+				for (int j = 0; j < size; j++) {
+					double x = j - size / 2;
+					double y = i - size / 2;
+					if ((std::abs(x * dx + y * dy) <= 35) && (std::abs(y * dx - x * dy) <= width / 2))
+						bar.at<uint8_t>(i, j) = 255;
+				}
+			}
+			cv::Mat skeleton = distance_skeleton(snapshot, bar);
+			check((skeleton_components(skeleton) == 1) && skeleton_thin(skeleton), "bar", width, angle);
+		}
+	}
+
+	// Filled discs centred on pixel and between pixels, discrete ridges meet in 3x3 junction
+	for (int radius = 4; radius <= 24; radius += 4) {
+		for (double centre: {35., 34.5}) {
+			cv::Mat disc = cv::Mat::zeros(70, 70, CV_8UC1);
+			for (int i = 0; i < disc.rows; i++) {
+				for (int j = 0; j < disc.cols; j++) {
+					if ((i - centre) * (i - centre) + (j - centre) * (j - centre) <= radius * radius)
+						disc.at<uint8_t>(i, j) = 255;
+				}
+			}
+			cv::Mat skeleton = distance_skeleton(snapshot, disc);
+			cv::Rect junction(std::floor(centre) - 1, std::floor(centre) - 1, 2, 2);
+			check((skeleton_components(skeleton) == 1) && skeleton_thin(skeleton, junction), "disc", 2 * radius, 0);
+		}
+	}
+	return failed;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s config [update]\n", argv[0]);
+		return 1;
+	}
+	bool update = (argc > 2) && (std::string(argv[2]) == "update");
+
+	parameters par;
+	regression_params reg;
+	reg.bind(par);
+	par.load_params(argv[1]);
+	parameters snapshot(par);
+
+	mkdir(reg.golden_dir->c_str(), 0777); // Generated images are stored there too
+
+	int skeleton_failed = check_skeleton_width(snapshot);
+	printf("Skeleton checks: %s\n", skeleton_failed ? "FAIL" : "ok");
+
+	std::vector<std::string> names;
+	FILE *fd = fopen(reg.corpus->c_str(), "r");
+	if (!fd) {
+		fprintf(stderr, "Unable to read corpus \"%s\".\n", reg.corpus->c_str());
+		return 1;
+	}
+	char *line;
+	while (fscanf(fd, "%m[^\n]\n", &line) >= 0) {
+		if (!line) // Skip empty line
+			continue;
+		int seed;
+		if (line[0] == '#') // Skip commented line
+			;
+		else if (sscanf(line, "synthetic %i", &seed) == 1)
+			names.push_back(synthetic_image(seed, *reg.golden_dir));
+		else if (sscanf(line, "drawing %i", &seed) == 1)
+			names.push_back(drawing_image(seed, *reg.golden_dir));
+		else
+			names.push_back(line);
+		free(line);
+	}
+	fclose(fd);
+
+	printf("%-32s %9s %9s %7s %7s %8s %8s %7s %8s  %s\n", "image", "time[s]", "rss[KiB]", "iou", "g.iou", "chamfer", "hausd.", "t.iou", "t.chamf", "status");
+	int failed = 0;
+	int skipped = 0;
+	for (const std::string &name: names) {
+		result res;
+		std::string error;
+		std::string status;
+		bool ok = run_isolated(snapshot, name, golden_base(*reg.golden_dir, name), *reg.tile_size, update, res, error);
+		if (!ok)
+			status = "ERROR " + error;
+		else {
+			if (res.input_iou < *reg.min_input_iou)
+				status += " input-iou";
+			if (res.has_golden) {
+				if (res.golden_iou < *reg.min_golden_iou)
+					status += " golden-iou";
+				if (res.chamfer > *reg.max_chamfer)
+					status += " chamfer";
+				if (res.hausdorff > *reg.max_hausdorff)
+					status += " hausdorff";
+			}
+			if (res.has_tiled) {
+				if (res.tiled_iou < *reg.min_tiled_iou)
+					status += " tiled-iou";
+				if (res.tiled_chamfer > *reg.max_tiled_chamfer)
+					status += " tiled-chamfer";
+			}
+			if (res.has_baseline) {
+				if ((*reg.max_time_ratio > 0) && (res.time > res.golden_time * *reg.max_time_ratio + 0.01)) // Ignore noise of very short runs
+					status += " time";
+				if ((*reg.max_rss_ratio > 0) && (res.rss > res.golden_rss * *reg.max_rss_ratio))
+					status += " rss";
+			}
+			ok = status.empty();
+			if (!ok)
+				status = "FAIL" + status;
+			else if (update)
+				status = "updated";
+			else if (!res.has_golden) {
+				status = "skipped (no golden)";
+				skipped++;
+			}
+			else
+				status = res.has_baseline ? "ok" : "ok (no baseline of this host)";
+		}
+		if (!ok)
+			failed++;
+		printf("%-32s %9.3f %9li %7.4f %7.4f %8.3f %8.3f %7.4f %8.3f  %s\n", name.substr(name.rfind('/') + 1).c_str(), res.time, res.rss, res.input_iou, res.golden_iou, res.chamfer, res.hausdorff, res.tiled_iou, res.tiled_chamfer, status.c_str());
+		fflush(stdout);
+	}
+	printf("%i of %i images failed\n", failed, (int) names.size());
+	if (skipped)
+		printf("%i images skipped: no golden output in \"%s\", create it by \"make regression_update\"\n", skipped, reg.golden_dir->c_str());
+	return !!(failed + skeleton_failed);
+}
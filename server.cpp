@@ -0,0 +1,273 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "server.h"
+#include "bounded_queue.h"
+#include "job.h"
+#include "parameters.h"
+#include "logger.h"
+#include "parallel.h"
+
+// Vectorization daemon listening on Unix domain socket
+
+namespace vectorix {
+
+const size_t max_header_size = 1 << 16;
+
+static bool client_param_allowed(const std::string &name) { // Clients can not open windows, change process settings or write files as server user
+	if (name.compare(0, 4, "file") == 0) // file_*, files_*: inputs and debug outputs
+		return false;
+	for (const char *prefix: {"server_", "batch_", "regression_"}) {
+		if (name.compare(0, strlen(prefix), prefix) == 0)
+			return false;
+	}
+	static const std::vector<std::string> refused = {"interactive", "show_rendered_window", "parameters_append", "cache_dir", "underlay_image", "threads",
+		"filter_mode", "filter_queue_size", "filter_length_prefix", "filter_verbosity"};
+	return std::find(refused.begin(), refused.end(), name) == refused.end();
+}
+
+const char *server::read_request(int client, std::string &header, int &shm_fd) {
+	shm_fd = -1;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(*param_server_timeout);
+	char buffer[4096];
+	while (header.find("\n\n") == std::string::npos) {
+		if (header.size() > max_header_size)
+			return "Invalid request.";
+		if (*param_server_timeout > 0) { // Whole header has to arrive in time, slow clients would occupy workers
+			auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+			if (left <= 0)
+				return "Request timed out.";
+			timeval timeout;
+			timeout.tv_sec = left / 1000000;
+			timeout.tv_usec = left % 1000000;
+			setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		}
+
+		iovec iov;
+		iov.iov_base = buffer;
+		iov.iov_len = sizeof(buffer);
+		char control[CMSG_SPACE(sizeof(int))];
+		msghdr msg;
+		std::memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		ssize_t len = recvmsg(client, &msg, 0);
+		if ((len < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+			return "Request timed out.";
+		if (len <= 0)
+			return "Invalid request."; // Connection closed before end of header
+		for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_RIGHTS)) { // Client passed file descriptor
+				if (shm_fd >= 0)
+					close(shm_fd);
+				std::memcpy(&shm_fd, CMSG_DATA(cmsg), sizeof(int));
+			}
+		}
+		header.append(buffer, len);
+	}
+	header.resize(header.find("\n\n") + 1);
+	return NULL;
+}
+
+void server::reply_error(int client, const char *message) {
+	std::string reply = std::string("ERR ") + message + "\n";
+	if (write(client, reply.c_str(), reply.size()) < 0)
+		log.log<log_level::debug>("Server: client is gone (%s)\n", strerror(errno));
+}
+
+void server::handle(const parameters &snapshot, int client) {
+	std::string header;
+	int shm_fd;
+	if (const char *request_error = read_request(client, header, shm_fd)) {
+		log.log<log_level::debug>("Server: %s\n", request_error);
+		reply_error(client, request_error);
+		if (shm_fd >= 0) // Descriptor received with incomplete header
+			close(shm_fd);
+		close(client);
+		return;
+	}
+
+	void *shm = MAP_FAILED;
+	size_t shm_size = 0;
+	std::vector<char> shm_copy; // Input of unsealed shared memory
+	std::string error;
+	try {
+		job j(snapshot);
+
+		// First line selects input, others are parameter overrides
+		size_t eol = header.find('\n');
+		std::string command = header.substr(0, eol);
+		std::string overrides = header.substr(eol + 1);
+		if (!overrides.empty()) {
+			auto read_overrides = [&](parameters &target) {
+				FILE *fd = fmemopen(&overrides[0], overrides.size(), "r");
+				if (!fd)
+					throw std::invalid_argument("Unable to read parameter overrides.");
+				target.load_params(fd);
+				fclose(fd);
+			};
+			parameters check; // Nothing is bound, all names stay in not_loaded
+			read_overrides(check);
+			for (const auto &o: check.not_loaded) {
+				if (!client_param_allowed(o.first))
+					throw std::invalid_argument("Parameter " + o.first + " can not be set by client.");
+			}
+			read_overrides(j.par); // Layered on copy of base parameters
+			int *param_interactive;
+			j.par.bind_param(param_interactive, "interactive", 1);
+			*param_interactive = 0; // Server workers never open windows
+		}
+
+		if (command.compare(0, 5, "FILE ") == 0) {
+			j.load(command.substr(5));
+		}
+		else if (command.compare(0, 3, "SHM") == 0) {
+			if (shm_fd < 0)
+				throw std::invalid_argument("No file descriptor with shared memory received.");
+			struct stat st;
+			if (fstat(shm_fd, &st) != 0)
+				throw std::invalid_argument("Unable to stat shared memory.");
+			shm_size = st.st_size;
+			if (command.size() > 4) // Client can send only part of buffer
+				shm_size = std::min<size_t>(shm_size, std::stoul(command.substr(4)));
+			int seals = fcntl(shm_fd, F_GET_SEALS);
+			if ((seals >= 0) && ((seals & (F_SEAL_SHRINK | F_SEAL_WRITE)) == (F_SEAL_SHRINK | F_SEAL_WRITE))) {
+				shm = mmap(NULL, shm_size, PROT_READ, MAP_SHARED, shm_fd, 0);
+				if (shm == MAP_FAILED)
+					throw std::invalid_argument("Unable to map shared memory.");
+				j.input.map(shm, shm_size); // Zero-copy, sealed memfd can not change under the mapping
+			}
+			else { // Client could truncate mapped file (SIGBUS) or change image while it is read
+				shm_copy.resize(shm_size);
+				for (size_t done = 0; done < shm_size;) {
+					ssize_t len = pread(shm_fd, &shm_copy[done], shm_size - done, done);
+					if (len <= 0)
+						throw std::invalid_argument("Unable to read shared memory.");
+					done += len;
+				}
+				j.input.map(shm_copy.data(), shm_size);
+			}
+		}
+		else
+			throw std::invalid_argument("Unknown command.");
+
+		j.vectorize();
+		log.log<log_level::info>("Server: %s: %fs\n", command.c_str(), j.vectorization_time);
+
+		int out_fd = dup(client);
+		FILE *out = (out_fd >= 0) ? fdopen(out_fd, "w") : NULL;
+		if (!out) {
+			if (out_fd >= 0)
+				close(out_fd);
+			throw std::invalid_argument("Unable to write output.");
+		}
+		fprintf(out, "OK\n");
+		j.write(out); // Stream output directly to client
+		fclose(out);
+	}
+	catch (const std::exception &e) {
+		error = e.what();
+	}
+	catch (const char *e) { // Vectorizer throws plain strings
+		error = e;
+	}
+	catch (...) {
+		error = "Unknown error.";
+	}
+	if (!error.empty()) {
+		log.log<log_level::warning>("Server: job failed: %s\n", error.c_str());
+		reply_error(client, error.c_str());
+	}
+
+	if (shm != MAP_FAILED)
+		munmap(shm, shm_size);
+	if (shm_fd >= 0)
+		close(shm_fd);
+	close(client);
+}
+
+int server::run() {
+	signal(SIGPIPE, SIG_IGN); // Disconnected client should not kill the server
+
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		log.log<log_level::error>("Server: unable to create socket: %s\n", strerror(errno));
+		return 1;
+	}
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (param_server_socket->size() >= sizeof(addr.sun_path)) {
+		log.log<log_level::error>("Server: socket path is too long.\n");
+		close(sock);
+		return 1;
+	}
+	strcpy(addr.sun_path, param_server_socket->c_str());
+	unlink(addr.sun_path); // Remove stale socket from previous run
+	if ((bind(sock, (sockaddr *) &addr, sizeof(addr)) != 0) || (listen(sock, *param_server_queue_size) != 0)) {
+		log.log<log_level::error>("Server: unable to listen on \"%s\": %s\n", addr.sun_path, strerror(errno));
+		close(sock);
+		return 1;
+	}
+
+	parameters snapshot(*par); // Base parameters, every job makes its own copy
+
+	int workers = worker_count(*param_server_workers);
+	log.log<log_level::info>("Server: listening on \"%s\" with %i workers\n", addr.sun_path, workers);
+
+	bounded_queue<int> clients(*param_server_queue_size);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < workers; t++) {
+		threads.emplace_back([&]() {
+			int client;
+			while (clients.pop(client))
+				handle(snapshot, client);
+		});
+	}
+
+	int ret = 0;
+	for (;;) {
+		int client = accept(sock, NULL, NULL);
+		if (client < 0) {
+			if (errno == EINTR)
+				continue;
+			log.log<log_level::error>("Server: accept failed: %s\n", strerror(errno));
+			ret = 1;
+			break;
+		}
+		if (!clients.try_push(client)) { // Queue is full, refuse immediately
+			reply_error(client, "Server is busy.");
+			close(client);
+		}
+	}
+
+	clients.close();
+	for (auto &t: threads)
+		t.join();
+	close(sock);
+	unlink(addr.sun_path);
+	return ret;
+}
+
+}; // namespace
@@ -0,0 +1,62 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__SERVER_H
+#define VECTORIX__SERVER_H
+
+// Vectorization daemon listening on Unix domain socket
+//
+// One job per connection. Client sends text header terminated by empty line:
+//   FILE <path>         input image is read from given file
+//   SHM [<size>]        input PNM is in memfd/shared memory, its file
+//                       descriptor is passed (SCM_RIGHTS) with the header;
+//                       memfd sealed with F_SEAL_SHRINK and F_SEAL_WRITE is
+//                       mapped without copy, other descriptors are copied
+//   <name> <value>      following lines override parameters for this job only
+//                       (not file names, windows and process settings)
+// Server answers "OK\n" followed by vector image (svg/ps) or "ERR <message>\n"
+// and closes the connection. Header not received within server_timeout seconds
+// is answered by error.
+
+#include <string>
+#include "parameters.h"
+#include "logger.h"
+
+namespace vectorix {
+
+class server {
+public:
+	server(parameters &params): par(&params) {
+		int *param_server_verbosity;
+		par->bind_param(param_server_verbosity, "server_verbosity", (int) log_level::info);
+		log.set_verbosity((log_level) *param_server_verbosity);
+
+		par->add_comment("Server mode: path of Unix domain socket to listen on, empty = no server");
+		par->bind_param(param_server_socket, "server_socket", (std::string) "");
+		par->add_comment("Count of jobs vectorized at once: 0 = number of cores");
+		par->bind_param(param_server_workers, "server_workers", 0);
+		par->add_comment("Maximal count of waiting jobs, other clients are refused");
+		par->bind_param(param_server_queue_size, "server_queue_size", 16);
+		par->add_comment("Seconds for client to send whole request header, 0 = no limit");
+		par->bind_param(param_server_timeout, "server_timeout", 10);
+	};
+	bool enabled() const { return !param_server_socket->empty(); };
+	int run(); // Serve until error, returns exit code
+private:
+	std::string *param_server_socket;
+	int *param_server_workers;
+	int *param_server_queue_size;
+	int *param_server_timeout;
+
+	void handle(const parameters &snapshot, int client); // Process one connection
+	const char *read_request(int client, std::string &header, int &shm_fd); // Read request header (and passed file descriptor), returns error message or NULL
+	void reply_error(int client, const char *message);
+
+	logger log;
+	parameters *par;
+};
+
+}; // namespace
+
+#endif
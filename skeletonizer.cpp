@@ -4,22 +4,37 @@
  */
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
 #include "parameters.h"
 #include "logger.h"
 #include "skeletonizer.h"
+#ifndef VECTORIX_HEADLESS
 #include "zoom_window.h"
+#endif
 #include "zhang_suen.h"
+#include "metrics.h"
+#include "bit_mat.h"
+#include "parallel.h"
 
 using namespace cv;
 
 namespace vectorix {
 
+const std::vector<std::string> skeletonizer::used_params = {"skeletonization_type"};
+
 void skeletonizer::skeletonize_circle(const Mat &source, Mat &skeleton, Mat &distance) {
 	Mat bw          (source.rows, source.cols, CV_8UC(1));
 	Mat next_peeled (source.rows, source.cols, CV_8UC(1));
 	skeleton = Mat::zeros(source.rows, source.cols, CV_8UC(1));
 	distance = Mat::zeros(source.rows, source.cols, CV_32SC1);
 	Mat peeled = source.clone(); // Objects in this image are peeled in every step by 1 px
+	count_mat(bw);
+	count_mat(next_peeled);
+	count_mat(skeleton);
+	count_mat(distance);
+	count_mat(peeled);
 
 	Mat kernel = getStructuringElement(MORPH_CROSS, Size(3,3)); // diamond
 	Mat kernel_2 = getStructuringElement(MORPH_RECT, Size(3,3)); // square
@@ -62,89 +77,97 @@ void skeletonizer::skeletonize_circle(const Mat &source, Mat &skeleton, Mat &dis
 }
 
 
-int skeletonizer::sum_8_connected(const Mat &img, Point p) {
-	int i = p.y;
-	int j = p.x;
-	return !!img.at<uint8_t>(i - 1, j) +
-	       !!img.at<uint8_t>(i - 1, j + 1) +
-	       !!img.at<uint8_t>(i,     j + 1) +
-	       !!img.at<uint8_t>(i + 1, j + 1) +
-	       !!img.at<uint8_t>(i + 1, j) +
-	       !!img.at<uint8_t>(i + 1, j - 1) +
-	       !!img.at<uint8_t>(i,     j - 1) +
-	       !!img.at<uint8_t>(i - 1, j - 1);
-}
-
-int skeletonizer::sum_4_connected(const Mat &img, Point p) {
-	int i = p.y;
-	int j = p.x;
-	return !!img.at<uint8_t>(i - 1, j) +
-	       !!img.at<uint8_t>(i,     j + 1) +
-	       !!img.at<uint8_t>(i + 1, j) +
-	       !!img.at<uint8_t>(i,     j - 1);
+void skeletonizer::save_step(const bit_mat &peeled) {
+	size_t number_sign = param_save_peeled_name->find("#");
+	std::string filename = std::to_string(iteration);
+	int zero = 3 - filename.length();
+	zero = (zero >= 0) ? zero : 0;
+	filename = param_save_peeled_name->substr(0, number_sign)
+		 + std::string(zero, '0')
+		 + filename
+		 + param_save_peeled_name->substr(number_sign + 1);
+	Mat image;
+	peeled.to_mat(image);
+	imwrite(filename, image);
 }
 
-void skeletonizer::skeletonize_diamond_square(const Mat &source, Mat &skeleton, Mat &distance) {
+void skeletonizer::skeletonize_diamond_square(const bit_mat &source, Mat &skeleton, Mat &distance) {
 	std::vector<Point> border_queue;
 	std::vector<Point> delete_queue;
 
 	skeleton = Mat::zeros(source.rows, source.cols, CV_8UC(1));
 	distance = Mat::zeros(source.rows, source.cols, CV_32SC1);
-	Mat peeled = source.clone(); // Objects in this image are peeled in every step by 1 px
-	Mat in_queue = Mat::zeros(source.rows, source.cols, CV_8UC(1));
+	bit_mat peeled = source; // Objects in this image are peeled in every step by 1 px
+	bit_mat queued(source.rows, source.cols); // Pixel is in border_queue or delete_queue
+	bit_mat deleted(source.rows, source.cols); // Pixel is (or was) in delete_queue
+	count_mat(skeleton);
+	count_mat(distance);
+	count_mat(peeled);
+	count_mat(queued);
+	count_mat(deleted);
+
+	// Pixels with at least one unset neighbour, 64 pixels at once
 	for (int i = 1 ; i < source.rows - 1; i++) {
-		for (int j = 1 ; j < source.cols - 1; j++) {
-			if (source.at<uint8_t>(i, j) && sum_8_connected(source, Point(j, i)) < 8) {
-				border_queue.emplace_back(Point(j, i));
-				in_queue.at<uint8_t>(i, j) = 1;
+		const uint64_t *rows[3] = {source.row(i - 1), source.row(i), source.row(i + 1)};
+		for (int w = 0; w < source.stride; w++) {
+			uint64_t inner = rows[1][w];
+			for (const uint64_t *r: rows) {
+				inner &= r[w];
+				inner &= (r[w] << 1) | (w ? r[w - 1] >> 63 : 0); // Left neighbours
+				inner &= (r[w] >> 1) | ((w + 1 < source.stride) ? r[w + 1] << 63 : 0); // Right neighbours
+			}
+			uint64_t border = rows[1][w] & ~inner;
+			while (border) {
+				int j = w * 64 + __builtin_ctzll(border);
+				border &= border - 1;
+				if ((j >= 1) && (j < source.cols - 1)) {
+					border_queue.emplace_back(Point(j, i));
+					queued.set(i, j);
+				}
 			}
 		}
 	}
 
+	if (*param_skeletonizer_parallel && (worker_count(*param_threads) > 1)) {
+		peel_parallel(peeled, queued, deleted, border_queue, skeleton, distance);
+		return;
+	}
+
+	auto gone = [&](int i, int j) { // Neighbour is peeled in this iteration or was peeled before
+		return deleted.get(i, j) || !peeled.get(i, j);
+	};
 	iteration = 1;
 	while (border_queue.size()) {
 		if ((*param_skeletonization_type & 1) == 0) {
 			log.log<log_level::info>("Skeletonizer (Diamond) iteration: %i (%i points)\n", iteration, border_queue.size());
-			if (!param_save_peeled_name->empty()) { // Save every step of skeletonization
-				size_t number_sign = param_save_peeled_name->find("#");
-				std::string filename = std::to_string(iteration);
-				int zero = 3 - filename.length();
-				zero = (zero >= 0) ? zero : 0;
-				filename = param_save_peeled_name->substr(0, number_sign)
-					 + std::string(zero, '0')
-					 + filename
-					 + param_save_peeled_name->substr(number_sign + 1);
-				imwrite(filename, peeled);
-			}
+			if (!param_save_peeled_name->empty()) // Save every step of skeletonization
+				save_step(peeled);
 			delete_queue.clear();
 			for (auto p: border_queue) {
 				int i = p.y;
 				int j = p.x;
-				if (peeled.at<uint8_t>(i, j) && sum_4_connected(peeled, Point(j, i)) < 4) {
-					in_queue.at<uint8_t>(i, j) = 2;
+				if (peeled.get(i, j) && peeled.sum_4_connected(i, j) < 4) {
+					deleted.set(i, j);
 					delete_queue.emplace_back(Point(j, i));
 				}
 				else
-					in_queue.at<uint8_t>(i, j) = 0;
+					queued.clear(i, j);
 			}
 			border_queue.clear();
 			for (auto p: delete_queue) {
 				int i = p.y;
 				int j = p.x;
-				if ((in_queue.at<uint8_t>(i - 1, j    ) == 2 || !peeled.at<uint8_t>(i - 1, j)) &&
-				    (in_queue.at<uint8_t>(i,     j + 1) == 2 || !peeled.at<uint8_t>(i,     j + 1)) &&
-				    (in_queue.at<uint8_t>(i + 1, j    ) == 2 || !peeled.at<uint8_t>(i + 1, j)) &&
-				    (in_queue.at<uint8_t>(i,     j - 1) == 2 || !peeled.at<uint8_t>(i,     j - 1))) {
+				if (gone(i - 1, j) && gone(i, j + 1) && gone(i + 1, j) && gone(i, j - 1)) {
 					skeleton.at<uint8_t>(i, j) = iteration;
 				}
-				peeled.at<uint8_t>(i, j) = 0;
+				peeled.clear(i, j);
 				distance.at<int32_t>(i, j) = iteration;
 
 				for (int i = p.y - 1; i <= p.y + 1; i++) {
 					for (int j = p.x - 1; j <= p.x + 1; j++) {
-						if (!in_queue.at<uint8_t>(i, j) && peeled.at<uint8_t>(i, j)) {
+						if (!queued.get(i, j) && peeled.get(i, j)) {
 							border_queue.emplace_back(Point(j, i));
-							in_queue.at<uint8_t>(i, j) = 1;
+							queued.set(i, j);
 						}
 					}
 				}
@@ -153,43 +176,28 @@ void skeletonizer::skeletonize_diamond_square(const Mat &source, Mat &skeleton,
 		}
 		if ((*param_skeletonization_type & 2) == 0) {
 			log.log<log_level::info>("Skeletonizer (Square) iteration: %i (%i points)\n", iteration, border_queue.size());
-			if (!param_save_peeled_name->empty()) { // Save every step of skeletonization
-				size_t number_sign = param_save_peeled_name->find("#");
-				std::string filename = std::to_string(iteration);
-				int zero = 3 - filename.length();
-				zero = (zero >= 0) ? zero : 0;
-				filename = param_save_peeled_name->substr(0, number_sign)
-					 + std::string(zero, '0')
-					 + filename
-					 + param_save_peeled_name->substr(number_sign + 1);
-				imwrite(filename, peeled);
-			}
+			if (!param_save_peeled_name->empty()) // Save every step of skeletonization
+				save_step(peeled);
 			for (auto p: border_queue) {
-				in_queue.at<uint8_t>(p) = 2;
+				deleted.set(p.y, p.x);
 			}
 			std::swap(border_queue, delete_queue);
 			border_queue.clear();
 			for (auto p: delete_queue) {
 				int i = p.y;
 				int j = p.x;
-				if ((in_queue.at<uint8_t>(i - 1, j    ) == 2 || !peeled.at<uint8_t>(i - 1, j)) &&
-				    (in_queue.at<uint8_t>(i - 1, j + 1) == 2 || !peeled.at<uint8_t>(i - 1, j + 1)) &&
-				    (in_queue.at<uint8_t>(i,     j + 1) == 2 || !peeled.at<uint8_t>(i,     j + 1)) &&
-				    (in_queue.at<uint8_t>(i + 1, j + 1) == 2 || !peeled.at<uint8_t>(i + 1, j + 1)) &&
-				    (in_queue.at<uint8_t>(i + 1, j    ) == 2 || !peeled.at<uint8_t>(i + 1, j)) &&
-				    (in_queue.at<uint8_t>(i + 1, j - 1) == 2 || !peeled.at<uint8_t>(i + 1, j - 1)) &&
-				    (in_queue.at<uint8_t>(i,     j - 1) == 2 || !peeled.at<uint8_t>(i,     j - 1)) &&
-				    (in_queue.at<uint8_t>(i - 1, j - 1) == 2 || !peeled.at<uint8_t>(i - 1, j - 1))) {
+				if (gone(i - 1, j) && gone(i - 1, j + 1) && gone(i, j + 1) && gone(i + 1, j + 1) &&
+				    gone(i + 1, j) && gone(i + 1, j - 1) && gone(i, j - 1) && gone(i - 1, j - 1)) {
 					skeleton.at<uint8_t>(i, j) = iteration;
 				}
-				peeled.at<uint8_t>(i, j) = 0;
+				peeled.clear(i, j);
 				distance.at<int32_t>(i, j) = iteration;
 
 				for (int i = p.y - 1; i <= p.y + 1; i++) {
 					for (int j = p.x - 1; j <= p.x + 1; j++) {
-						if (!in_queue.at<uint8_t>(i, j) && peeled.at<uint8_t>(i, j)) {
+						if (!queued.get(i, j) && peeled.get(i, j)) {
 							border_queue.emplace_back(Point(j, i));
-							in_queue.at<uint8_t>(i, j) = 1;
+							queued.set(i, j);
 						}
 					}
 				}
@@ -199,18 +207,185 @@ void skeletonizer::skeletonize_diamond_square(const Mat &source, Mat &skeleton,
 	}
 }
 
-void skeletonizer::run(const Mat &binary_input, Mat &skeleton, Mat &distance) {
-	// Create boarders around image, white (background) pixels
-	Mat source;
-	copyMakeBorder(binary_input, source, 1, 1, 1, 1, BORDER_CONSTANT, Scalar(0, 0, 0));
+void skeletonizer::skeletonize_distance(const bit_mat &source, Mat &skeleton, Mat &distance) {
+	// Felzenszwalb & Huttenlocher: squared distance to background in columns, then lower
+	// envelope of parabolas in every row. Source has background border, all distances are finite.
+	log.log<log_level::info>("Skeletonizer (Distance transform)\n");
+	skeleton = Mat::zeros(source.rows, source.cols, CV_8UC(1));
+	distance = Mat(source.rows, source.cols, CV_32SC1);
+	count_mat(skeleton);
+	count_mat(distance);
+	int threads = worker_count(*param_threads);
 
-	log.log<log_level::debug>("Image size without border: %i x %i\n", binary_input.cols, binary_input.rows);
-	log.log<log_level::debug>("Image size with border: %i x %i\n", source.cols, source.rows);
+	// Vertical distance, two sweeps over rows (columns are split among threads)
+	int chunks = std::min(threads, source.cols);
+	parallel_for(chunks, threads, [&](int chunk, int) {
+		int from = (int64_t) source.cols * chunk / chunks;
+		int to = (int64_t) source.cols * (chunk + 1) / chunks;
+		for (int i = 0; i < source.rows; i++) {
+			int32_t *d = distance.ptr<int32_t>(i);
+			const int32_t *up = i ? distance.ptr<int32_t>(i - 1) : NULL;
+			for (int j = from; j < to; j++)
+				d[j] = source.get(i, j) ? (up ? up[j] + 1 : source.rows) : 0;
+		}
+		for (int i = source.rows - 2; i >= 0; i--) {
+			int32_t *d = distance.ptr<int32_t>(i);
+			const int32_t *down = distance.ptr<int32_t>(i + 1);
+			for (int j = from; j < to; j++)
+				d[j] = std::min(d[j], down[j] + 1);
+		}
+	});
+
+	// Horizontal pass, rows are independent
+	parallel_for(source.rows, threads, [&](int i, int) {
+		int32_t *d = distance.ptr<int32_t>(i);
+		int n = source.cols;
+		std::vector<int64_t> f(n);
+		std::vector<int> v(n); // Parabolas of lower envelope
+		std::vector<double> z(n + 1); // Boundaries between them
+		for (int j = 0; j < n; j++)
+			f[j] = (int64_t) d[j] * d[j];
+		int k = 0;
+		v[0] = 0;
+		z[0] = -HUGE_VAL;
+		z[1] = HUGE_VAL;
+		for (int q = 1; q < n; q++) {
+			double s;
+			while ((s = ((f[q] + (int64_t) q * q) - (f[v[k]] + (int64_t) v[k] * v[k])) / (2. * (q - v[k]))) <= z[k])
+				k--;
+			k++;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = HUGE_VAL;
+		}
+		k = 0;
+		for (int q = 0; q < n; q++) {
+			while (z[k + 1] < q)
+				k++;
+			d[q] = std::min<int64_t>(INT32_MAX, (int64_t) (q - v[k]) * (q - v[k]) + f[v[k]]); // Clamped for strokes wider than 2 * 46340 px
+		}
+	});
+
+	// Ridges: strict local maxima of squared distance across any of four directions.
+	// They have gaps on slanted strokes and none on plateaus of even-width strokes,
+	// so they are only anchors (ends and branches) of thinning below.
+	enum { background = 0, object = 1, ridge = 2 };
+	parallel_for(source.rows - 2, threads, [&](int r, int) {
+		int i = r + 1;
+		const int32_t *up = distance.ptr<int32_t>(i - 1);
+		const int32_t *d = distance.ptr<int32_t>(i);
+		const int32_t *down = distance.ptr<int32_t>(i + 1);
+		uint8_t *out = skeleton.ptr<uint8_t>(i);
+		for (int j = 1; j < source.cols - 1; j++) {
+			int32_t c = d[j];
+			if (!c)
+				continue;
+			auto maximum = [c](int32_t a, int32_t b) { return (c > a) && (c > b); };
+			if (maximum(d[j - 1], d[j + 1]) || maximum(up[j], down[j]) || maximum(up[j - 1], down[j + 1]) || maximum(up[j + 1], down[j - 1]))
+				out[j] = ridge;
+			else
+				out[j] = object;
+		}
+	});
+
+	// Distance-ordered thinning: pixels are removed from the nearest to background if
+	// they are simple (8-connected object stays connected) and not ends of lines.
+	// Bucket queue by squared distance: pixels are counting-sorted once, neighbours of
+	// removed pixel which were already passed are checked again within current bucket.
+	// Thinning ends in fixpoint with one pixel wide centre line also on plateaus and
+	// slanted strokes. Ridges are thinned afterwards, only where they form 2x2 blocks.
+	int32_t max_key = 0; // Squared distance is below pixel count of object, buckets are linear in size of image
+	for (int i = 1; i < source.rows - 1; i++) {
+		const int32_t *d = distance.ptr<int32_t>(i);
+		for (int j = 1; j < source.cols - 1; j++)
+			max_key = std::max(max_key, d[j]);
+	}
+	auto thin = [&](uint8_t kind, bool blocks_only) {
+		std::vector<int> bucket_end(max_key + 2, 0);
+		for (int i = 1; i < source.rows - 1; i++) {
+			const int32_t *d = distance.ptr<int32_t>(i);
+			const uint8_t *out = skeleton.ptr<uint8_t>(i);
+			for (int j = 1; j < source.cols - 1; j++)
+				bucket_end[d[j] + 1] += (out[j] == kind);
+		}
+		for (int32_t key = 0; key <= max_key; key++)
+			bucket_end[key + 1] += bucket_end[key];
+		std::vector<Point> order(bucket_end[max_key + 1]);
+		for (int i = 1; i < source.rows - 1; i++) {
+			const int32_t *d = distance.ptr<int32_t>(i);
+			const uint8_t *out = skeleton.ptr<uint8_t>(i);
+			for (int j = 1; j < source.cols - 1; j++) {
+				if (out[j] == kind)
+					order[bucket_end[d[j]]++] = Point(j, i); // Start of bucket moves to its end
+			}
+		}
+
+		std::vector<Point> again; // Neighbours of removed pixels in passed buckets
+		auto remove = [&](Point p, int32_t key) {
+			if (skeleton.at<uint8_t>(p) != kind)
+				return; // Already removed
+			const uint8_t *up = skeleton.ptr<uint8_t>(p.y - 1) + p.x;
+			const uint8_t *row = skeleton.ptr<uint8_t>(p.y) + p.x;
+			const uint8_t *down = skeleton.ptr<uint8_t>(p.y + 1) + p.x;
+			bool n[9] = {!!row[1], !!up[1], !!up[0], !!up[-1], !!row[-1], !!down[-1], !!down[0], !!down[1], !!row[1]}; // Counterclockwise from east, east again at the end
+			int neighbours = 0;
+			for (int k = 0; k < 8; k++)
+				neighbours += n[k];
+			int connectivity = 0; // Connectivity number of 8-connected object
+			bool block = false; // Pixel is corner of 2x2 block
+			for (int k = 0; k < 8; k += 2) {
+				connectivity += !n[k] && (n[k + 1] || n[k + 2]);
+				block = block || (n[k] && n[k + 1] && n[k + 2]);
+			}
+			if ((neighbours < 2) || (connectivity != 1) || (blocks_only && !block))
+				return;
+			skeleton.at<uint8_t>(p) = background;
+			for (int y = p.y - 1; y <= p.y + 1; y++) {
+				for (int x = p.x - 1; x <= p.x + 1; x++) {
+					if ((y < 1) || (x < 1) || (y >= source.rows - 1) || (x >= source.cols - 1) || (skeleton.at<uint8_t>(y, x) != kind))
+						continue;
+					if (distance.at<int32_t>(y, x) <= key) // Later buckets are checked anyway
+						again.push_back(Point(x, y));
+				}
+			}
+		};
+		int b = 0;
+		for (int32_t key = 0; key <= max_key; key++) {
+			for (; b < bucket_end[key]; b++)
+				remove(order[b], key);
+			for (size_t a = 0; a < again.size(); a++) // Grows while it is processed
+				remove(again[a], key);
+			again.clear();
+		}
+	};
+	thin(object, false);
+	thin(ridge, true);
+
+	// Distance in pixels (rounded, at least 1 inside objects), skeleton holds distance as other types
+	std::vector<int> max_distance(threads, 0);
+	parallel_for(source.rows, threads, [&](int i, int w) {
+		int32_t *d = distance.ptr<int32_t>(i);
+		uint8_t *out = skeleton.ptr<uint8_t>(i);
+		for (int j = 0; j < source.cols; j++) {
+			if (!d[j])
+				continue;
+			d[j] = std::max(1, (int) std::lround(std::sqrt((double) d[j])));
+			max_distance[w] = std::max(max_distance[w], d[j]);
+			if (out[j])
+				out[j] = std::min(255, d[j]);
+		}
+	});
+	iteration = *std::max_element(max_distance.begin(), max_distance.end()) + 1; // Same meaning as after peeling
+}
 
+void skeletonizer::skeletonize(const Mat &source, Mat &skeleton, Mat &distance) {
 	if (*param_skeletonization_type == 4) {
+		bit_mat bits;
+		bits.from_mat(source);
+		count_mat(bits);
 		*param_skeletonization_type = 0;
 		Mat temp;
-		skeletonize_diamond_square(source, temp, distance);
+		skeletonize_diamond_square(bits, temp, distance);
 		*param_skeletonization_type = 4;
 
 		zhang_suen zs(*par);
@@ -222,15 +397,63 @@ void skeletonizer::run(const Mat &binary_input, Mat &skeleton, Mat &distance) {
 			}
 		}
 	}
-	else if (*param_skeletonization_type == 3)
-		skeletonize_circle(source, skeleton, distance);
 	else
-		skeletonize_diamond_square(source, skeleton, distance);
+		skeletonize_circle(source, skeleton, distance);
+}
+
+void skeletonizer::run(const Mat &binary_input, Mat &skeleton, Mat &distance) {
+	stage_timer time("skeletonization");
+	log.log<log_level::debug>("Image size without border: %i x %i\n", binary_input.cols, binary_input.rows);
+	if ((*param_skeletonization_type == 3) || (*param_skeletonization_type == 4)) {
+		// Create boarders around image, white (background) pixels
+		Mat source;
+		copyMakeBorder(binary_input, source, 1, 1, 1, 1, BORDER_CONSTANT, Scalar(0, 0, 0));
+		count_mat(source);
+		skeletonize(source, skeleton, distance);
+	}
+	else {
+		bit_mat source;
+		source.from_mat(binary_input, 1); // With border
+		count_mat(source);
+		if (*param_skeletonization_type == 5)
+			skeletonize_distance(source, skeleton, distance);
+		else
+			skeletonize_diamond_square(source, skeleton, distance);
+	}
+	finish(skeleton, distance);
+}
+
+void skeletonizer::run(const bit_mat &binary_input, Mat &skeleton, Mat &distance) {
+	stage_timer time("skeletonization");
+	log.log<log_level::debug>("Image size without border: %i x %i\n", binary_input.cols, binary_input.rows);
+	if ((*param_skeletonization_type == 3) || (*param_skeletonization_type == 4)) { // These need 8bit image
+		bit_mat bordered;
+		binary_input.copy_with_border(bordered, 1);
+		Mat source;
+		bordered.to_mat(source);
+		count_mat(source);
+		skeletonize(source, skeleton, distance);
+	}
+	else {
+		bit_mat source;
+		binary_input.copy_with_border(source, 1);
+		count_mat(source);
+		if (*param_skeletonization_type == 5)
+			skeletonize_distance(source, skeleton, distance);
+		else
+			skeletonize_diamond_square(source, skeleton, distance);
+	}
+	finish(skeleton, distance);
+}
 
-	Rect crop(1, 1, binary_input.cols, binary_input.rows);
+void skeletonizer::finish(Mat &skeleton, Mat &distance) {
+	log.log<log_level::debug>("Image size with border: %i x %i\n", skeleton.cols, skeleton.rows);
+	Rect crop(1, 1, skeleton.cols - 2, skeleton.rows - 2);
 	skeleton = skeleton(crop);
 	distance = distance(crop);
 	log.log<log_level::debug>("Image size after cropping: %i x %i\n", skeleton.cols, skeleton.rows);
+	if (metrics::current())
+		count(counter::skeleton_pixels, countNonZero(skeleton));
 
 	if (!param_save_skeleton_name->empty()) { // Save output to file
 		imwrite(*param_save_skeleton_name, skeleton);
@@ -261,6 +484,7 @@ void skeletonizer::normalize(const cv::Mat &in, cv::Mat &out, int max) {
 }
 
 void skeletonizer::interactive(TrackbarCallback onChange, void *userdata) {
+#ifndef VECTORIX_HEADLESS
 	Mat distance_show; // Images normalized for displaying
 	Mat skeleton_show; // Images normalized for displaying
 
@@ -274,8 +498,9 @@ void skeletonizer::interactive(TrackbarCallback onChange, void *userdata) {
 	threshold(skeleton_show, skeleton_show, 0, 255, THRESH_BINARY);
 	zoom_imshow("Skeleton", skeleton_show);
 
-	createTrackbar("Skeletonization", "Skeleton", param_skeletonization_type, 4, onChange, userdata);
+	createTrackbar("Skeletonization", "Skeleton", param_skeletonization_type, 5, onChange, userdata);
 	waitKey(1);
+#endif
 };
 
 }; // namespace
@@ -6,8 +6,11 @@
 #define VECTORIX__SKELETONIZER_H
 
 #include <opencv2/opencv.hpp>
+#include <vector>
+#include <string>
 #include "parameters.h"
 #include "logger.h"
+#include "bit_mat.h"
 
 namespace vectorix {
 
@@ -19,7 +22,8 @@ public:
 		log.set_verbosity((log_level) *param_vectorizer_verbosity);
 
 		par->add_comment("Phase 2: Skeletonization");
-		par->add_comment("Skeletonization type: 0: diamond-square, 1: square, 2: diamond, 3: circle (slow), 4: zhang-suen + diamod-square");
+		par->add_comment("Skeletonization type: 0: diamond-square, 1: square, 2: diamond, 3: circle (slow), 4: zhang-suen + diamod-square,");
+		par->add_comment("  5: exact euclidean distance (thinning in order of distance, kept ridges of distance)");
 		par->bind_param(param_skeletonization_type, "skeletonization_type", 4);
 		par->add_comment("Save steps to files, # will be replaced with iteration number");
 		par->bind_param(param_save_peeled_name, "files_steps_output", (std::string) "");
@@ -28,10 +32,16 @@ public:
 		par->bind_param(param_save_distance_name, "file_distance", (std::string) "");
 		par->bind_param(param_save_skeleton_normalized_name, "file_skeleton_norm", (std::string) "");
 		par->bind_param(param_save_distance_normalized_name, "file_distance_norm", (std::string) "");
+		par->add_comment("Parallel peeling (diamond-square types): 0: off, 1: split frontier of every iteration among worker threads");
+		par->bind_param(param_skeletonizer_parallel, "skeletonizer_parallel", 0);
+		par->bind_param(param_threads, "threads", 0);
 	}
 	void run(const cv::Mat &binary_input, cv::Mat &skeleton, cv::Mat &distance);
+	void run(const bit_mat &binary_input, cv::Mat &skeleton, cv::Mat &distance); // Bit-packed input, same output
+	bool bits_supported() const { return (*param_skeletonization_type != 3) && (*param_skeletonization_type != 4); }; // Bit-packed input is used without unpacking to 8bit image
 	void interactive(cv::TrackbarCallback onChange = 0, void *userdata = 0);
 
+	static const std::vector<std::string> used_params; // Parameters which change output of run()
 private:
 	// Add pixels from `bw' to `out'. Something like image `or', but with more information
 	template <typename T>
@@ -46,10 +56,14 @@ private:
 	}
 	void normalize(const cv::Mat &in, cv::Mat &out, int max);
 
+	void skeletonize(const cv::Mat &source, cv::Mat &skeleton, cv::Mat &distance); // Source with border, types using 8bit images
+	void finish(cv::Mat &skeleton, cv::Mat &distance); // Crop border, save outputs
 	void skeletonize_circle(const cv::Mat &input, cv::Mat &skeleton, cv::Mat &distance);
-	void skeletonize_diamond_square(const cv::Mat &input, cv::Mat &skeleton, cv::Mat &distance);
-	int sum_8_connected(const cv::Mat &img, cv::Point p);
-	int sum_4_connected(const cv::Mat &img, cv::Point p);
+	void skeletonize_diamond_square(const bit_mat &input, cv::Mat &skeleton, cv::Mat &distance);
+	// Peeling loop of diamond-square on worker threads, same output as serial loop, see skeletonizer_parallel.cpp
+	void peel_parallel(bit_mat &peeled, bit_mat &queued, bit_mat &deleted, std::vector<cv::Point> &border_queue, cv::Mat &skeleton, cv::Mat &distance);
+	void skeletonize_distance(const bit_mat &input, cv::Mat &skeleton, cv::Mat &distance); // Exact euclidean distance transform
+	void save_step(const bit_mat &peeled); // Save image of current iteration
 
 	int *param_skeletonization_type;
 	std::string *param_save_peeled_name;
@@ -57,6 +71,8 @@ private:
 	std::string *param_save_distance_name;
 	std::string *param_save_skeleton_normalized_name;
 	std::string *param_save_distance_normalized_name;
+	int *param_skeletonizer_parallel;
+	int *param_threads;
 
 	logger log;
 	parameters *par;
@@ -0,0 +1,126 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <algorithm>
+#include "parameters.h"
+#include "logger.h"
+#include "skeletonizer.h"
+#include "bit_mat.h"
+#include "parallel.h"
+
+// Parallel diamond-square peeling
+//
+// Frontier of every step is split into contiguous chunks. Threads only read
+// peeled/queued/deleted images (and write skeleton and distance of their own
+// pixels), changes of bit images are done by merging results of chunks in
+// order. Queue order and so the output are the same as in serial peeling.
+
+using namespace cv;
+
+namespace vectorix {
+
+class peel_chunk { // Results of one part of queue
+public:
+	std::vector<Point> remove; // Pixels peeled in this step
+	std::vector<Point> keep; // Pixels leaving queue
+	std::vector<Point> found; // Candidates for next frontier, in order of discovery (with duplicates)
+};
+
+template <typename F>
+static int process_chunks(const std::vector<Point> &queue, std::vector<peel_chunk> &chunks, int threads, F func) { // Returns count of used chunks
+	const size_t min_chunk = 1024; // Small frontiers are not worth starting threads
+	int count = std::max<size_t>(1, std::min<size_t>(threads, queue.size() / min_chunk));
+	parallel_for(count, count, [&](int c, int) {
+		peel_chunk &ch = chunks[c];
+		ch.remove.clear();
+		ch.keep.clear();
+		ch.found.clear();
+		size_t to = queue.size() * (c + 1) / count;
+		for (size_t k = queue.size() * c / count; k < to; k++)
+			func(queue[k], ch);
+	});
+	return count;
+}
+
+void skeletonizer::peel_parallel(bit_mat &peeled, bit_mat &queued, bit_mat &deleted, std::vector<Point> &border_queue, Mat &skeleton, Mat &distance) {
+	int threads = worker_count(*param_threads);
+	std::vector<peel_chunk> chunks(threads);
+	std::vector<Point> delete_queue;
+
+	auto gone = [&](int i, int j) { // Neighbour is peeled in this iteration or was peeled before
+		return deleted.get(i, j) || !peeled.get(i, j);
+	};
+	auto peel = [&](bool diamond) { // Peel pixels of delete_queue, next frontier to border_queue
+		// Pixels peeled earlier in this step are in deleted, so reading peeled before any change gives the same answers
+		int count = process_chunks(delete_queue, chunks, threads, [&](const Point &p, peel_chunk &ch) {
+			int i = p.y;
+			int j = p.x;
+			bool skel = gone(i - 1, j) && gone(i, j + 1) && gone(i + 1, j) && gone(i, j - 1);
+			if (!diamond)
+				skel = skel && gone(i - 1, j + 1) && gone(i + 1, j + 1) && gone(i + 1, j - 1) && gone(i - 1, j - 1);
+			if (skel)
+				skeleton.at<uint8_t>(i, j) = iteration;
+			distance.at<int32_t>(i, j) = iteration;
+
+			for (int i = p.y - 1; i <= p.y + 1; i++) {
+				for (int j = p.x - 1; j <= p.x + 1; j++) {
+					if (!queued.get(i, j) && peeled.get(i, j))
+						ch.found.emplace_back(Point(j, i));
+				}
+			}
+		});
+		for (auto p: delete_queue)
+			peeled.clear(p.y, p.x);
+		border_queue.clear();
+		for (int c = 0; c < count; c++) {
+			for (auto p: chunks[c].found) {
+				if (!queued.get(p.y, p.x)) { // First discovery wins, as in serial loop
+					border_queue.emplace_back(p);
+					queued.set(p.y, p.x);
+				}
+			}
+		}
+	};
+
+	iteration = 1;
+	while (border_queue.size()) {
+		if ((*param_skeletonization_type & 1) == 0) {
+			log.log<log_level::info>("Skeletonizer (Diamond, parallel) iteration: %i (%i points)\n", iteration, border_queue.size());
+			if (!param_save_peeled_name->empty()) // Save every step of skeletonization
+				save_step(peeled);
+			int count = process_chunks(border_queue, chunks, threads, [&](const Point &p, peel_chunk &ch) {
+				if (peeled.get(p.y, p.x) && peeled.sum_4_connected(p.y, p.x) < 4)
+					ch.remove.emplace_back(p);
+				else
+					ch.keep.emplace_back(p);
+			});
+			delete_queue.clear();
+			for (int c = 0; c < count; c++) {
+				for (auto p: chunks[c].remove) {
+					deleted.set(p.y, p.x);
+					delete_queue.emplace_back(p);
+				}
+				for (auto p: chunks[c].keep)
+					queued.clear(p.y, p.x);
+			}
+			peel(true);
+			iteration++;
+		}
+		if ((*param_skeletonization_type & 2) == 0) {
+			log.log<log_level::info>("Skeletonizer (Square, parallel) iteration: %i (%i points)\n", iteration, border_queue.size());
+			if (!param_save_peeled_name->empty()) // Save every step of skeletonization
+				save_step(peeled);
+			for (auto p: border_queue) {
+				deleted.set(p.y, p.x);
+			}
+			std::swap(border_queue, delete_queue);
+			peel(false);
+			iteration++;
+		}
+	}
+}
+
+}; // namespace
@@ -0,0 +1,286 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <functional>
+#include <unistd.h>
+#include "parameters.h"
+#include "logger.h"
+#include "stage_cache.h"
+
+// On-disk cache of stage outputs
+//
+// File format: "VXC1", count of matrices (uint32) and for each matrix:
+// rows, cols, type (int32), encoding (char), payload size (uint64) and payload.
+// Encodings: 'B' -- 8bit image with values 0/255 only, packed to bits
+//            'R' -- 8bit or 32bit single channel, runs of zeros + varint literals
+//            'N' -- anything else, raw rows
+
+using namespace cv;
+
+namespace vectorix {
+
+const char cache_magic[] = "VXC1";
+
+static void fnv1a(uint64_t &h, const void *data, size_t len) { // 64bit FNV-1a
+	const uint8_t *byte = static_cast<const uint8_t *>(data);
+	for (size_t i = 0; i < len; i++) {
+		h ^= byte[i];
+		h *= 1099511628211ull;
+	}
+}
+
+uint64_t stage_cache::hash(const Mat &image, uint64_t seed) {
+	uint64_t h = 14695981039346656037ull ^ seed;
+	int header[3] = {image.rows, image.cols, image.type()};
+	fnv1a(h, header, sizeof(header));
+	size_t row_size = image.cols * image.elemSize();
+	for (int i = 0; i < image.rows; i++)
+		fnv1a(h, image.ptr(i), row_size);
+	return h;
+}
+
+uint64_t stage_cache::key(uint64_t input, const std::vector<std::string> &param_names) {
+	std::string values = par->fingerprint(param_names);
+	uint64_t h = 14695981039346656037ull;
+	fnv1a(h, &input, sizeof(input));
+	fnv1a(h, values.data(), values.size());
+	return h;
+}
+
+std::string stage_cache::filename(uint64_t key, const char *stage) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.", (unsigned long long) key);
+	return *param_cache_dir + "/" + name + stage;
+}
+
+/*
+ * Encoding
+ */
+
+static void put_varint(std::string &out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back((char) ((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char) value);
+}
+
+static bool get_varint(const uint8_t *&pos, const uint8_t *end, uint64_t &value) {
+	value = 0;
+	for (int shift = 0; (pos < end) && (shift < 64); shift += 7) {
+		uint8_t byte = *pos++;
+		value |= (uint64_t) (byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static int64_t element(const Mat &mat, int i, int j) {
+	if (mat.type() == CV_32SC1)
+		return mat.at<int32_t>(i, j);
+	return mat.at<uint8_t>(i, j);
+}
+
+static char encode(const Mat &mat, std::string &out) {
+	if (mat.type() == CV_8UC1) {
+		bool bilevel = true;
+		for (int i = 0; bilevel && (i < mat.rows); i++) {
+			const uint8_t *row = mat.ptr<uint8_t>(i);
+			for (int j = 0; j < mat.cols; j++) {
+				if (row[j] && (row[j] != 255)) {
+					bilevel = false;
+					break;
+				}
+			}
+		}
+		if (bilevel) { // Pack 8 pixels to one byte
+			uint8_t byte = 0;
+			int bits = 0;
+			for (int i = 0; i < mat.rows; i++) {
+				const uint8_t *row = mat.ptr<uint8_t>(i);
+				for (int j = 0; j < mat.cols; j++) {
+					byte = (byte << 1) | !!row[j];
+					if (++bits == 8) {
+						out.push_back((char) byte);
+						byte = 0;
+						bits = 0;
+					}
+				}
+			}
+			if (bits)
+				out.push_back((char) (byte << (8 - bits)));
+			return 'B';
+		}
+	}
+	if ((mat.type() == CV_8UC1) || (mat.type() == CV_32SC1)) { // Mostly zero images (skeleton, distance)
+		size_t total = (size_t) mat.rows * mat.cols;
+		size_t pos = 0;
+		while (pos < total) {
+			size_t zeros = 0;
+			while ((pos + zeros < total) && !element(mat, (pos + zeros) / mat.cols, (pos + zeros) % mat.cols))
+				zeros++;
+			pos += zeros;
+			size_t literals = 0;
+			while ((pos + literals < total) && element(mat, (pos + literals) / mat.cols, (pos + literals) % mat.cols))
+				literals++;
+			put_varint(out, zeros);
+			put_varint(out, literals);
+			for (size_t k = 0; k < literals; k++, pos++) {
+				int64_t v = element(mat, pos / mat.cols, pos % mat.cols);
+				put_varint(out, (v << 1) ^ (v >> 63)); // Zigzag, small negative numbers are short too
+			}
+		}
+		return 'R';
+	}
+	size_t row_size = mat.cols * mat.elemSize();
+	for (int i = 0; i < mat.rows; i++)
+		out.append((const char *) mat.ptr(i), row_size);
+	return 'N';
+}
+
+static bool decode(char encoding, const uint8_t *pos, const uint8_t *end, Mat &mat) {
+	if (encoding == 'B') {
+		if ((size_t) (end - pos) < ((size_t) mat.rows * mat.cols + 7) / 8)
+			return false;
+		size_t bit = 0;
+		for (int i = 0; i < mat.rows; i++) {
+			uint8_t *row = mat.ptr<uint8_t>(i);
+			for (int j = 0; j < mat.cols; j++, bit++)
+				row[j] = (pos[bit / 8] & (0x80 >> (bit % 8))) ? 255 : 0;
+		}
+		return true;
+	}
+	if (encoding == 'R') {
+		size_t total = (size_t) mat.rows * mat.cols;
+		size_t idx = 0;
+		while (idx < total) {
+			uint64_t zeros, literals;
+			if (!get_varint(pos, end, zeros) || !get_varint(pos, end, literals) || (idx + zeros + literals > total))
+				return false;
+			for (uint64_t k = 0; k < zeros; k++, idx++) {
+				if (mat.type() == CV_32SC1)
+					mat.at<int32_t>(idx / mat.cols, idx % mat.cols) = 0;
+				else
+					mat.at<uint8_t>(idx / mat.cols, idx % mat.cols) = 0;
+			}
+			for (uint64_t k = 0; k < literals; k++, idx++) {
+				uint64_t z;
+				if (!get_varint(pos, end, z))
+					return false;
+				int64_t v = (int64_t) (z >> 1) ^ -(int64_t) (z & 1);
+				if (mat.type() == CV_32SC1)
+					mat.at<int32_t>(idx / mat.cols, idx % mat.cols) = v;
+				else
+					mat.at<uint8_t>(idx / mat.cols, idx % mat.cols) = v;
+			}
+		}
+		return true;
+	}
+	if (encoding == 'N') {
+		size_t row_size = mat.cols * mat.elemSize();
+		if ((size_t) (end - pos) < row_size * mat.rows)
+			return false;
+		for (int i = 0; i < mat.rows; i++, pos += row_size)
+			std::memcpy(mat.ptr(i), pos, row_size);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Cache files
+ */
+
+bool stage_cache::load(uint64_t key, const char *stage, std::vector<Mat> &mats) {
+	std::string name = filename(key, stage);
+	FILE *fd = fopen(name.c_str(), "rb");
+	if (!fd)
+		return false; // Not cached yet
+	std::string content;
+	char buffer[1 << 16];
+	size_t len;
+	while ((len = fread(buffer, 1, sizeof(buffer), fd)) > 0)
+		content.append(buffer, len);
+	fclose(fd);
+
+	const uint8_t *pos = (const uint8_t *) content.data();
+	const uint8_t *end = pos + content.size();
+	uint32_t count;
+	bool ok = (content.size() >= 8) && !std::memcmp(pos, cache_magic, 4);
+	if (ok) {
+		std::memcpy(&count, pos + 4, sizeof(count));
+		pos += 8;
+		mats.clear();
+	}
+	for (uint32_t m = 0; ok && (m < count); m++) {
+		int32_t header[3];
+		char encoding;
+		uint64_t size;
+		if ((size_t) (end - pos) < sizeof(header) + 1 + sizeof(size)) {
+			ok = false;
+			break;
+		}
+		std::memcpy(header, pos, sizeof(header));
+		pos += sizeof(header);
+		encoding = *pos++;
+		std::memcpy(&size, pos, sizeof(size));
+		pos += sizeof(size);
+		if (((uint64_t) (end - pos) < size) || (header[0] < 0) || (header[1] < 0)) {
+			ok = false;
+			break;
+		}
+		Mat mat(header[0], header[1], header[2]);
+		ok = decode(encoding, pos, pos + size, mat);
+		mats.push_back(mat);
+		pos += size;
+	}
+	if (!ok) {
+		log.log<log_level::warning>("Cache: ignoring corrupted file \"%s\"\n", name.c_str());
+		mats.clear();
+		return false;
+	}
+	log.log<log_level::info>("Cache: using %s\n", name.c_str());
+	return true;
+}
+
+void stage_cache::store(uint64_t key, const char *stage, const std::vector<Mat> &mats) {
+	std::string content(cache_magic, 4);
+	uint32_t count = mats.size();
+	content.append((const char *) &count, sizeof(count));
+	for (const Mat &mat: mats) {
+		std::string payload;
+		char encoding = encode(mat, payload);
+		int32_t header[3] = {mat.rows, mat.cols, mat.type()};
+		uint64_t size = payload.size();
+		content.append((const char *) header, sizeof(header));
+		content.push_back(encoding);
+		content.append((const char *) &size, sizeof(size));
+		content.append(payload);
+	}
+
+	// Write to temporary file and rename, concurrent readers never see partial entry
+	std::string name = filename(key, stage);
+	std::string tmp_name = name + ".tmp" + std::to_string(getpid()) + "_" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	FILE *fd = fopen(tmp_name.c_str(), "wb");
+	if (!fd) {
+		log.log<log_level::warning>("Cache: unable to write \"%s\"\n", tmp_name.c_str());
+		return;
+	}
+	bool ok = fwrite(content.data(), 1, content.size(), fd) == content.size();
+	ok = (fclose(fd) == 0) && ok;
+	if (!ok || rename(tmp_name.c_str(), name.c_str())) {
+		log.log<log_level::warning>("Cache: unable to write \"%s\"\n", name.c_str());
+		unlink(tmp_name.c_str());
+	}
+}
+
+}; // namespace
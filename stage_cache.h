@@ -0,0 +1,48 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__STAGE_CACHE_H
+#define VECTORIX__STAGE_CACHE_H
+
+// On-disk cache of stage outputs (threshold, skeleton), content addressed by
+// hash of input pixels and parameters used by stage
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "parameters.h"
+#include "logger.h"
+
+namespace vectorix {
+
+class stage_cache {
+public:
+	stage_cache(parameters &params): par(&params) {
+		int *param_vectorizer_verbosity;
+		par->bind_param(param_vectorizer_verbosity, "vectorizer_verbosity", (int) log_level::warning);
+		log.set_verbosity((log_level) *param_vectorizer_verbosity);
+
+		par->add_comment("Directory for caching threshold and skeleton results (only without interactive mode): empty = no caching");
+		par->bind_param(param_cache_dir, "cache_dir", (std::string) "");
+	};
+	bool enabled() const { return !param_cache_dir->empty(); };
+
+	static uint64_t hash(const cv::Mat &image, uint64_t seed = 0); // Hash of pixel data
+	uint64_t key(uint64_t input, const std::vector<std::string> &param_names); // Key of stage output (input hash + parameters)
+
+	bool load(uint64_t key, const char *stage, std::vector<cv::Mat> &mats); // Returns false if there is no such entry
+	void store(uint64_t key, const char *stage, const std::vector<cv::Mat> &mats);
+private:
+	std::string *param_cache_dir;
+
+	std::string filename(uint64_t key, const char *stage);
+
+	logger log;
+	parameters *par;
+};
+
+}; // namespace
+
+#endif
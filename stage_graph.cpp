@@ -0,0 +1,66 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <string>
+#include <vector>
+#include <functional>
+#include "parameters.h"
+#include "logger.h"
+#include "timer.h"
+#include "stage_graph.h"
+
+namespace vectorix {
+
+int stage_graph::add(const std::string &name, const std::vector<std::string> &param_names, std::function<void()> func, const std::vector<int> &depends) {
+	stage s;
+	s.name = name;
+	s.param_names = param_names;
+	s.func = func;
+	s.depends = depends;
+	s.stale = true; // Never run
+	stages.push_back(s);
+	return stages.size() - 1;
+}
+
+void stage_graph::check() {
+	// Stages are in topological order, single pass propagates staleness
+	for (int i = 0; i < (int) stages.size(); i++) {
+		stage &s = stages[i];
+		if (s.stale)
+			continue;
+		for (int dep: s.depends) {
+			if (stages[dep].stale)
+				s.stale = true;
+		}
+		if (!s.stale && (par->fingerprint(s.param_names) != s.fingerprint)) {
+			log.log<log_level::debug>("%s: parameters changed\n", s.name.c_str());
+			s.stale = true;
+		}
+	}
+}
+
+void stage_graph::invalidate(int stage) {
+	stages[stage].stale = true;
+	check();
+}
+
+void stage_graph::update(int stage) {
+	stage_graph::stage &s = stages[stage];
+	for (int dep: s.depends)
+		update(dep);
+	if (!s.stale)
+		return;
+
+	timer stage_timer;
+	stage_timer.start();
+	s.func();
+	stage_timer.stop();
+	log.log<log_level::info>("%s time: %fs\n", s.name.c_str(), stage_timer.read());
+
+	// Stage can adjust its own parameters (e.g. make them valid), remember values after run
+	s.fingerprint = par->fingerprint(s.param_names);
+	s.stale = false;
+}
+
+}; // namespace
@@ -0,0 +1,55 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__STAGE_GRAPH_H
+#define VECTORIX__STAGE_GRAPH_H
+
+// Dependency graph of vectorization stages for incremental re-execution
+// Each stage declares parameters it reads, stage is rerun only if some of them
+// (or some stage it depends on) changed since its last run.
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "parameters.h"
+#include "logger.h"
+
+namespace vectorix {
+
+class stage_graph {
+public:
+	stage_graph(parameters &params): par(&params) {
+		int *param_vectorizer_verbosity;
+		par->bind_param(param_vectorizer_verbosity, "vectorizer_verbosity", (int) log_level::warning);
+		log.set_verbosity((log_level) *param_vectorizer_verbosity);
+	};
+
+	// Add stage, dependencies have to be added before. Returns index of the stage.
+	int add(const std::string &name, const std::vector<std::string> &param_names, std::function<void()> func, const std::vector<int> &depends = {});
+
+	void check(); // Mark stages with changed parameters (and all stages depending on them) stale
+	void invalidate(int stage); // Mark stage and all stages depending on it stale
+	void update(int stage); // Rerun stale stages needed for given stage (including itself)
+
+	bool stale(int stage) const { return stages[stage].stale; };
+	int size() const { return stages.size(); };
+private:
+	class stage {
+	public:
+		std::string name;
+		std::vector<std::string> param_names;
+		std::function<void()> func;
+		std::vector<int> depends;
+		std::string fingerprint; // Values of parameters during last run
+		bool stale;
+	};
+	std::vector<stage> stages;
+
+	logger log;
+	parameters *par;
+};
+
+}; // namespace
+
+#endif
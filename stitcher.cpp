@@ -0,0 +1,156 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+#include "v_image.h"
+#include "geom.h"
+#include "stitcher.h"
+
+// Join lines traced separately in neighbouring parts of an image
+
+namespace vectorix {
+
+void stitcher::shift(v_line &line, v_pt offset) {
+	for (v_point &pt: line.segment) {
+		pt.main += offset;
+		pt.control_prev += offset;
+		pt.control_next += offset;
+	}
+}
+
+void stitcher::cut(const v_line &line, p x0, p y0, p x1, p y1, int region, std::vector<line_fragment> &fragments) {
+	auto inside = [&](const v_pt &pt) {
+		return (pt.x >= x0) && (pt.x < x1) && (pt.y >= y0) && (pt.y < y1);
+	};
+
+	line_fragment current;
+	current.region = region;
+	const v_point *outside = NULL; // Last point outside of the region
+	for (const v_point &pt: line.segment) {
+		if (inside(pt.main)) {
+			if (current.line.empty() && outside) { // Line enters the region
+				current.line.segment.push_back(*outside);
+				current.open[0] = true;
+			}
+			current.line.segment.push_back(pt);
+			outside = NULL;
+		}
+		else {
+			if (!current.line.empty()) { // Line leaves the region
+				current.line.segment.push_back(pt);
+				current.open[1] = true;
+				fragments.push_back(current);
+				current = line_fragment();
+				current.region = region;
+			}
+			outside = &pt;
+		}
+	}
+	if (!current.line.empty())
+		fragments.push_back(current);
+}
+
+// Fragment end: index of fragment * 2 + (0: start, 1: end)
+static const v_pt &inner_point(const line_fragment &fragment, int side) { // Last point of fragment inside its region
+	if (fragment.line.segment.size() < 2)
+		return fragment.line.segment.front().main;
+	if (side == 0)
+		return std::next(fragment.line.segment.begin())->main;
+	return std::prev(fragment.line.segment.end(), 2)->main;
+}
+
+void stitcher::stitch(std::vector<line_fragment> &fragments, p tolerance, v_image &output) {
+	// Find candidate pairs of open ends using grid with cell size = tolerance
+	std::unordered_map<long long, std::vector<int>> grid;
+	auto cell = [&](const v_pt &pt, int dx, int dy) {
+		long long x = std::floor(pt.x / tolerance) + dx;
+		long long y = std::floor(pt.y / tolerance) + dy;
+		return (x << 32) ^ (y & 0xffffffff);
+	};
+	for (int f = 0; f < (int) fragments.size(); f++) {
+		for (int side = 0; side < 2; side++) {
+			if (fragments[f].open[side] && (fragments[f].line.segment.size() >= 2))
+				grid[cell(inner_point(fragments[f], side), 0, 0)].push_back(f*2 + side);
+		}
+	}
+	std::vector<std::tuple<p, int, int>> pairs; // distance, end, end
+	for (auto &c: grid) {
+		for (int a: c.second) {
+			const v_pt &pa = inner_point(fragments[a/2], a%2);
+			for (int dy = -1; dy <= 1; dy++) {
+				for (int dx = -1; dx <= 1; dx++) {
+					auto near = grid.find(cell(pa, dx, dy));
+					if (near == grid.end())
+						continue;
+					for (int b: near->second) {
+						if ((b <= a) || (fragments[a/2].region == fragments[b/2].region))
+							continue;
+						p d = geom::distance(pa, inner_point(fragments[b/2], b%2));
+						if (d <= tolerance)
+							pairs.emplace_back(d, a, b);
+					}
+				}
+			}
+		}
+	}
+	std::sort(pairs.begin(), pairs.end()); // Closest ends first, ties by position in input
+
+	std::vector<int> link(fragments.size() * 2, -1); // End joined with given end
+	for (auto &pair: pairs) {
+		int a = std::get<1>(pair);
+		int b = std::get<2>(pair);
+		if ((link[a] >= 0) || (link[b] >= 0) || (a/2 == b/2))
+			continue;
+		link[a] = b;
+		link[b] = a;
+	}
+
+	// Walk through chains of joined fragments
+	std::vector<bool> used(fragments.size(), false);
+	auto walk = [&](int first, int side) { // Start with fragment `first', its free end is `side'
+		v_line line;
+		int f = first;
+		int entry = side; // End through which we enter fragment f
+		for (;;) {
+			used[f] = true;
+			v_line part = fragments[f].line;
+			if (entry == 1)
+				part.reverse();
+			if (f != first) { // Drop overlapping points and connect inner points straight
+				part.segment.pop_front();
+				line.segment.pop_back();
+				v_point &a = line.segment.back();
+				v_point &b = part.segment.front();
+				a.control_next = a.main + (b.main - a.main) / 3;
+				b.control_prev = b.main + (a.main - b.main) / 3;
+			}
+			line.segment.splice(line.segment.end(), part.segment);
+			int exit = f*2 + (1 - entry);
+			int next = link[exit];
+			if ((next < 0) || used[next/2])
+				break;
+			f = next/2;
+			entry = next%2;
+		}
+		output.add_line(line);
+	};
+	for (int f = 0; f < (int) fragments.size(); f++) { // Chains with free end
+		if (used[f])
+			continue;
+		if (link[f*2] < 0)
+			walk(f, 0);
+		else if (link[f*2 + 1] < 0)
+			walk(f, 1);
+	}
+	for (int f = 0; f < (int) fragments.size(); f++) { // Closed loops
+		if (!used[f])
+			walk(f, 0);
+	}
+}
+
+}; // namespace
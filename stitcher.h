@@ -0,0 +1,36 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__STITCHER_H
+#define VECTORIX__STITCHER_H
+
+// Join lines traced separately in neighbouring parts of an image
+
+#include <vector>
+#include "v_image.h"
+#include "config.h"
+
+namespace vectorix {
+
+class line_fragment { // Part of a line traced inside one region
+public:
+	v_line line;
+	// Line was cut at region border (at start/end). First/last point is then
+	// the first point outside of the region and it is dropped when joined.
+	bool open[2] = {false, false};
+	int region = 0; // Only fragments from different regions are joined
+};
+
+namespace stitcher {
+	// Cut line to fragments inside of [x0, x1) x [y0, y1)
+	void cut(const v_line &line, p x0, p y0, p x1, p y1, int region, std::vector<line_fragment> &fragments);
+	// Join open ends closer than tolerance and add resulting lines to image
+	void stitch(std::vector<line_fragment> &fragments, p tolerance, v_image &output);
+	// Move every point of a line by offset
+	void shift(v_line &line, v_pt offset);
+};
+
+}; // namespace
+
+#endif
@@ -0,0 +1,183 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include "stream_decoder.h"
+#include "bounded_queue.h"
+#include "pnm_handler.h"
+#include "pnm_kernels.h"
+#include "thresholder.h"
+#include "metrics.h"
+
+// Streaming input: threshold binary PNM image band by band
+
+using namespace cv;
+
+namespace vectorix {
+
+bool stream_decoder::enabled() {
+	if (!*param_stream_input)
+		return false;
+	if ((*param_threshold_type != 0) && (*param_threshold_type != 1)) {
+		log.log<log_level::warning>("Streaming input works only with global threshold, whole image is loaded.\n");
+		return false;
+	}
+	if ((*param_tile_size > 0) || !param_cache_dir->empty() || *param_interactive) {
+		log.log<log_level::warning>("Streaming input does not work with tiles, stage cache and interactive mode, whole image is loaded.\n");
+		return false;
+	}
+	return true;
+}
+
+bool stream_decoder::supported(const std::string &filename) {
+	FILE *fd = fopen(filename.c_str(), "r");
+	if (!fd)
+		return false; // Normal loading reports the error
+	char magic[2] = {};
+	bool binary = (fread(magic, 1, 2, fd) == 2) && (magic[0] == 'P') && (magic[1] >= '4') && (magic[1] <= '6');
+	fclose(fd);
+	if (!binary)
+		log.log<log_level::warning>("Streaming input supports only binary PNM images, whole image is loaded.\n");
+	return binary;
+}
+
+void stream_decoder::downsample(const Mat &pixels, int first_row, Mat &color) {
+	int scale = *param_stream_color_scale;
+	int channels = pixels.channels();
+	if (scale == 1) { // Only copy
+		Mat out = color.rowRange(first_row, first_row + pixels.rows);
+		if (channels == 3)
+			pixels.copyTo(out);
+		else
+			cvtColor(pixels, out, CV_GRAY2BGR);
+		return;
+	}
+	for (int y = 0; y < pixels.rows; y += scale) { // Bands start at multiple of scale
+		int rows = std::min(scale, pixels.rows - y);
+		uint8_t *out = color.ptr<uint8_t>((first_row + y) / scale);
+		for (int x = 0; x < pixels.cols; x += scale, out += 3) {
+			int cols = std::min(scale, pixels.cols - x);
+			for (int c = 0; c < 3; c++) {
+				int sum = 0;
+				for (int i = 0; i < rows; i++) {
+					const uint8_t *in = pixels.ptr<uint8_t>(y + i) + x*channels + ((channels == 3) ? c : 0);
+					for (int j = 0; j < cols; j++)
+						sum += in[j*channels];
+				}
+				out[c] = (sum + rows*cols/2) / (rows*cols);
+			}
+		}
+	}
+}
+
+void stream_decoder::run(FILE *fd, Mat &binary, Mat &color) {
+	stage_timer time("decode");
+	pnm_image header(*par);
+	header.read_info(fd);
+	if (header.type < pnm_variant_type::binary_pbm)
+		throw std::invalid_argument("Streaming input supports only binary PNM images.");
+	int width = header.width;
+	int height = header.height;
+	int channels = (header.type == pnm_variant_type::binary_ppm) ? 3 : 1;
+	size_t row_bytes = (header.type == pnm_variant_type::binary_pbm) ? (width - 1) / 8 + 1 : (size_t) width * channels;
+
+	int scale = std::max(0, *param_stream_color_scale);
+	int band = std::max(1, *param_stream_band_rows);
+	if (scale > 1)
+		band = (band + scale - 1) / scale * scale; // Blocks of color image never cross bands
+	bool otsu = (*param_threshold_type == 0);
+	log.log<log_level::info>("Streaming input: %ix%i, %i rows per band, color scale %i\n", width, height, band, scale);
+
+	binary = Mat(height, width, CV_8UC(1)); // Grayscale values for Otsu's threshold, thresholded in place at the end
+	count_mat(binary);
+	if (scale > 0) {
+		color = Mat((height + scale - 1) / scale, (width + scale - 1) / scale, CV_8UC(3));
+		count_mat(color);
+	}
+	else
+		color = Mat();
+
+	bounded_queue<std::vector<uint8_t>> bands(4);
+	std::atomic<bool> truncated(false);
+	std::thread reader([&]() {
+		for (int r = 0; r < height; r += band) {
+			std::vector<uint8_t> buffer(std::min(band, height - r) * row_bytes);
+			if (fread(buffer.data(), 1, buffer.size(), fd) != buffer.size()) {
+				truncated = true;
+				break;
+			}
+			if (!bands.push(std::move(buffer)))
+				break; // Conversion failed
+		}
+		bands.close();
+	});
+
+	std::vector<long> histogram(256, 0);
+	int row = 0;
+	try {
+		std::vector<uint8_t> buffer;
+		Mat pixels, gray;
+		while (bands.pop(buffer)) {
+			int rows = buffer.size() / row_bytes;
+			if (header.type == pnm_variant_type::binary_pbm) {
+				pixels.create(rows, width, CV_8UC(1));
+				for (int i = 0; i < rows; i++) // Black pixels (bit 1) are 0
+					pnm_kernels::unpack_bits(buffer.data() + i*row_bytes, pixels.ptr<uint8_t>(i), width, 0, 255);
+			}
+			else
+				pixels = Mat(rows, width, CV_8UC(channels), buffer.data());
+
+			if (scale > 0)
+				downsample(pixels, row, color);
+
+			if (channels == 3)
+				cvtColor(pixels, gray, CV_BGR2GRAY); // RGB data, same weights as thresholder::to_grayscale
+			else
+				gray = pixels;
+			if (*param_invert_input)
+				subtract(Scalar(255), gray, gray);
+
+			Mat out = binary.rowRange(row, row + rows);
+			if (otsu) {
+				gray.copyTo(out);
+				for (int i = 0; i < rows; i++) {
+					const uint8_t *g = out.ptr<uint8_t>(i);
+					for (int j = 0; j < width; j++)
+						histogram[g[j]]++;
+				}
+			}
+			else
+				cv::threshold(gray, out, *param_threshold, 255, THRESH_BINARY);
+			row += rows;
+		}
+	}
+	catch (...) {
+		bands.close(); // Stop reader
+		reader.join();
+		throw;
+	}
+	reader.join();
+	if (truncated || (row != height)) {
+		log.log<log_level::error>("Error: image data are truncated (%i of %i rows).\n", row, height);
+		throw std::underflow_error("Unable to read image data.");
+	}
+
+	if (otsu) {
+		int value = thresholder::otsu_threshold(histogram);
+		log.log<log_level::info>("Streaming input: Otsu's threshold %i\n", value);
+		cv::threshold(binary, binary, value, 255, THRESH_BINARY);
+	}
+
+	if (!param_save_threshold_name->empty())
+		imwrite(*param_save_threshold_name, binary);
+}
+
+}; // namespace
@@ -0,0 +1,67 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__STREAM_DECODER_H
+#define VECTORIX__STREAM_DECODER_H
+
+// Streaming input: binary PNM image is read in bands of rows, every band is
+// converted to grayscale and thresholded as soon as it arrives. Only binary
+// image and (optionally downsampled) color image for tracer are stored.
+// Reading of next band (own thread) overlaps with conversion of current one.
+
+#include <opencv2/opencv.hpp>
+#include <cstdio>
+#include <string>
+#include "parameters.h"
+#include "logger.h"
+
+namespace vectorix {
+
+class stream_decoder {
+public:
+	stream_decoder(parameters &params): par(&params) {
+		int *param_vectorizer_verbosity;
+		par->bind_param(param_vectorizer_verbosity, "vectorizer_verbosity", (int) log_level::warning);
+		log.set_verbosity((log_level) *param_vectorizer_verbosity);
+
+		par->add_comment("Streaming input (binary PNM, custom vectorizer, global threshold only): 0: whole image is loaded first, 1: threshold rows as they are read");
+		par->bind_param(param_stream_input, "stream_input", 0);
+		par->add_comment("Streaming input: rows read at once");
+		par->bind_param(param_stream_band_rows, "stream_band_rows", 64);
+		par->add_comment("Streaming input: color image kept for tracer, 0: none (black lines), 1: full size, N: downsampled N times");
+		par->bind_param(param_stream_color_scale, "stream_color_scale", 1);
+
+		par->bind_param(param_invert_input, "invert_colors", 1);
+		par->bind_param(param_threshold_type, "threshold_type", 0);
+		par->bind_param(param_threshold, "threshold", 127);
+		par->bind_param(param_save_threshold_name, "file_threshold_output", (std::string) "");
+		par->bind_param(param_tile_size, "tile_size", 0);
+		par->bind_param(param_cache_dir, "cache_dir", (std::string) "");
+		par->bind_param(param_interactive, "interactive", 1);
+	};
+	bool enabled(); // Streaming is requested and possible with current settings
+	bool supported(const std::string &filename); // File is binary PNM (ASCII variants are loaded whole)
+	void run(FILE *fd, cv::Mat &binary, cv::Mat &color); // Read one image, color is in RGB order (or empty)
+	int color_scale() const { return *param_stream_color_scale; };
+private:
+	int *param_stream_input;
+	int *param_stream_band_rows;
+	int *param_stream_color_scale;
+	int *param_invert_input;
+	int *param_threshold_type;
+	int *param_threshold;
+	std::string *param_save_threshold_name;
+	int *param_tile_size;
+	std::string *param_cache_dir;
+	int *param_interactive;
+
+	void downsample(const cv::Mat &pixels, int first_row, cv::Mat &color); // Average blocks of band to color image
+
+	logger log;
+	parameters *par;
+};
+
+}; // namespace
+
+#endif
@@ -3,87 +3,449 @@
  * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
  */
 #include <opencv2/opencv.hpp>
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
 #include "parameters.h"
 #include "logger.h"
 #include "thresholder.h"
+#ifndef VECTORIX_HEADLESS
 #include "zoom_window.h"
+#endif
+#include "metrics.h"
+#include "pnm_kernels.h"
+#include "parallel.h"
+#include "components.h"
 
 using namespace cv;
 
 namespace vectorix {
 
-void thresholder::run(const Mat &original, Mat &bin) {
-	max_image_size = original.cols + original.rows;
-	grayscale = Mat(original.rows, original.cols, CV_8UC(1)); // Grayscale original
-	cvtColor(original, grayscale, CV_RGB2GRAY);
+const std::vector<std::string> thresholder::threshold_params = {"invert_colors", "threshold_type", "threshold", "adaptive_threshold_size", "adaptive_threshold_k", "adaptive_threshold_range"};
+const std::vector<std::string> thresholder::filter_params = {"filter_type", "fill_holes", "dust_size", "hole_area", "dust_area"};
+const std::vector<std::string> thresholder::used_params = {"invert_colors", "threshold_type", "threshold", "adaptive_threshold_size", "adaptive_threshold_k", "adaptive_threshold_range", "filter_type", "fill_holes", "dust_size", "hole_area", "dust_area"};
+
+void thresholder::to_grayscale(const Mat &original, Mat &gray) {
+	gray = Mat(original.rows, original.cols, CV_8UC(1)); // Grayscale original
+	cvtColor(original, gray, rgb_order ? CV_BGR2GRAY : CV_RGB2GRAY); // Same result for both orders as when PNM data were copied to BGR and converted by CV_RGB2GRAY
 
 	// Invert black/white
 	if (*param_invert_input)
-		subtract(Scalar(255,255,255), grayscale, grayscale);
+		subtract(Scalar(255,255,255), gray, gray);
+}
+
+int thresholder::otsu_threshold(const std::vector<long> &histogram) { // Maximize between-class variance
+	long total = 0;
+	double mu = 0;
+	for (int i = 0; i < 256; i++) {
+		total += histogram[i];
+		mu += i * (double) histogram[i];
+	}
+	if (!total)
+		return 0;
+	double scale = 1. / total;
+	mu *= scale;
+
+	double mu1 = 0, q1 = 0;
+	double max_sigma = 0;
+	int max_val = 0;
+	for (int i = 0; i < 256; i++) {
+		double p_i = histogram[i] * scale;
+		mu1 *= q1;
+		q1 += p_i;
+		double q2 = 1. - q1;
+		if ((std::min(q1, q2) < FLT_EPSILON) || (std::max(q1, q2) > 1. - FLT_EPSILON))
+			continue;
+		mu1 = (mu1 + i * p_i) / q1;
+		double mu2 = (mu - q1 * mu1) / q2;
+		double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+		if (sigma > max_sigma) {
+			max_sigma = sigma;
+			max_val = i;
+		}
+	}
+	return max_val;
+}
+
+void thresholder::run(const Mat &original, Mat &bin) {
+	threshold(original, bin);
+	filter(bin);
+}
+
+void thresholder::threshold_fused(const Mat &original, Mat &bin) {
+	bool otsu = (*param_threshold_type == 0);
+	log.log<log_level::info>(otsu ? "threshold: Using Otsu's algorithm (single pass)\n" : "threshold: Using binary threshold %i (single pass).\n", *param_threshold);
+	bin.create(original.rows, original.cols, CV_8UC(1));
+	count_mat(bin);
+
+	// Bands of rows small enough to stay in cache between conversion and thresholding
+	int band_rows = std::max(1, (32 << 10) / std::max(1, original.cols));
+	Mat band;
+	if (!otsu)
+		band.create(band_rows, original.cols, CV_8UC(1));
+	std::vector<long> histogram(256, 0);
+	for (int y = 0; y < original.rows; y += band_rows) {
+		int rows = std::min(band_rows, original.rows - y);
+		Mat gray = otsu ? bin.rowRange(y, y + rows) : band.rowRange(0, rows); // Otsu needs whole histogram first, grayscale waits in output
+		cvtColor(original.rowRange(y, y + rows), gray, rgb_order ? CV_BGR2GRAY : CV_RGB2GRAY);
+		for (int i = 0; i < rows; i++) {
+			uint8_t *row = gray.ptr<uint8_t>(i);
+			if (otsu) {
+				for (int j = 0; j < gray.cols; j++)
+					histogram[row[j]]++;
+			}
+			else {
+				uint8_t *out = bin.ptr<uint8_t>(y + i);
+				if (*param_invert_input) {
+					for (int j = 0; j < gray.cols; j++)
+						out[j] = (255 - row[j] > *param_threshold) ? 255 : 0;
+				}
+				else {
+					for (int j = 0; j < gray.cols; j++)
+						out[j] = (row[j] > *param_threshold) ? 255 : 0;
+				}
+			}
+		}
+	}
+	if (!otsu)
+		return;
+
+	if (*param_invert_input)
+		std::reverse(histogram.begin(), histogram.end()); // Histogram of inverted image
+	int value = otsu_threshold(histogram);
+	uint8_t lut[256];
+	for (int g = 0; g < 256; g++)
+		lut[g] = (((*param_invert_input) ? 255 - g : g) > value) ? 255 : 0;
+	for (int i = 0; i < bin.rows; i++) {
+		uint8_t *row = bin.ptr<uint8_t>(i);
+		for (int j = 0; j < bin.cols; j++)
+			row[j] = lut[row[j]];
+	}
+}
+
+void thresholder::threshold_integral(const Mat &gray, Mat &bin) {
+	// Sum (and sum of squares) of any window is given by four values of integral image.
+	// Windows are clipped by image borders, only pixels inside are counted.
+	int type = *param_threshold_type;
+	Mat sum, sqsum;
+	if (type == 4)
+		integral(gray, sum, CV_64F);
+	else
+		integral(gray, sum, sqsum, CV_64F, CV_64F);
+	count_mat(sum);
+	count_mat(sqsum);
+	bin.create(gray.rows, gray.cols, CV_8UC(1));
+	count_mat(bin);
+
+	int half = *param_adaptive_threshold_size / 2;
+	p bias = *param_threshold - 128;
+	p k = *param_adaptive_threshold_k;
+	p range = std::max((p) 1, *param_adaptive_threshold_range);
+	const int band_rows = 64;
+	int bands = (gray.rows + band_rows - 1) / band_rows;
+	parallel_for(bands, worker_count(*param_threads, bands), [&](int band, int) {
+		for (int i = band * band_rows; i < std::min(gray.rows, (band + 1) * band_rows); i++) {
+			int y0 = std::max(0, i - half);
+			int y1 = std::min(gray.rows, i + half + 1);
+			const double *top = sum.ptr<double>(y0);
+			const double *bottom = sum.ptr<double>(y1);
+			const double *sqtop = sqsum.empty() ? NULL : sqsum.ptr<double>(y0);
+			const double *sqbottom = sqsum.empty() ? NULL : sqsum.ptr<double>(y1);
+			const uint8_t *in = gray.ptr<uint8_t>(i);
+			uint8_t *out = bin.ptr<uint8_t>(i);
+			for (int j = 0; j < gray.cols; j++) {
+				int x0 = std::max(0, j - half);
+				int x1 = std::min(gray.cols, j + half + 1);
+				p n = (p) (y1 - y0) * (x1 - x0);
+				p mean = (bottom[x1] - bottom[x0] - top[x1] + top[x0]) / n;
+				p t;
+				if (type == 4) // Same rule as adaptive mean: above mean minus bias
+					t = mean - bias;
+				else {
+					p var = (sqbottom[x1] - sqbottom[x0] - sqtop[x1] + sqtop[x0]) / n - mean * mean;
+					p dev = std::sqrt(std::max((p) 0, var));
+					if (type == 5) // Sauvola's formula for bright lines on dark background (image is already inverted)
+						t = 255 - (255 - mean) * (1 + k * (dev / range - 1));
+					else // Niblack
+						t = mean + k * dev;
+				}
+				out[j] = (in[j] > t) ? 255 : 0;
+			}
+		}
+	});
+}
+
+void thresholder::threshold(const Mat &original, Mat &bin) {
+	stage_timer time("threshold");
+	max_image_size = original.cols + original.rows;
+	grayscale.release();
+	binary.release();
+	filled.release();
+	threshold_mat(original, bin);
+
+	if (*param_interactive) { // Later stages modify bin
+		this->binary = bin.clone();
+		count_mat(this->binary);
+	}
+
+	// Save image after thresholding
+	if (!param_save_threshold_name->empty()) {
+		imwrite(*param_save_threshold_name, bin);
+	}
+}
+
+void thresholder::threshold_mat(const Mat &original, Mat &bin) {
+	if (!*param_interactive && (*param_threshold_type >= 0) && (*param_threshold_type <= 1) && (original.type() == CV_8UC(3))) // Global threshold, no windows to show
+		threshold_fused(original, bin);
+	else {
+		Mat gray;
+		to_grayscale(original, gray);
+		count_mat(gray);
+
+		// Do Thresholding
+		if ((*param_threshold_type >= 2) && (*param_threshold_type <= 3)) { // Adaptive threshold
+			log.log<log_level::info>("threshold: Using adaptive threshold with bias %i.\n", *param_threshold - 128);
 
+			// Make threshold size odd and >= 3.
+			*param_adaptive_threshold_size |= 1;
+			if (*param_adaptive_threshold_size < 3)
+				*param_adaptive_threshold_size = 3;
 
-	// Do Thresholding
-	if ((*param_threshold_type >= 2) && (*param_threshold_type <= 3)) { // Adaptive threshold
-		log.log<log_level::info>("threshold: Using adaptive threshold with bias %i.\n", *param_threshold - 128);
+			int type = ADAPTIVE_THRESH_GAUSSIAN_C; // *param_threshold_type == 2 --> gaussian
+			if (*param_threshold_type == 3)
+				type = ADAPTIVE_THRESH_MEAN_C; // *param_threshold_type == 3 --> mean
 
-		// Make threshold size odd and >= 3.
-		*param_adaptive_threshold_size |= 1;
-		if (*param_adaptive_threshold_size < 3)
-			*param_adaptive_threshold_size = 3;
+			adaptiveThreshold(gray, bin, 255, type, THRESH_BINARY, *param_adaptive_threshold_size, *param_threshold - 128);
+		}
+		else if ((*param_threshold_type >= 4) && (*param_threshold_type <= 6)) { // Adaptive threshold from integral image
+			*param_adaptive_threshold_size |= 1;
+			if (*param_adaptive_threshold_size < 3)
+				*param_adaptive_threshold_size = 3;
 
-		int type = ADAPTIVE_THRESH_GAUSSIAN_C; // *param_threshold_type == 2 --> gaussian
-		if (*param_threshold_type == 3)
-			type = ADAPTIVE_THRESH_MEAN_C; // *param_threshold_type == 3 --> mean
+			const char *names[] = {"mean", "Sauvola", "Niblack"};
+			log.log<log_level::info>("threshold: Using adaptive %s threshold (integral image), window %i.\n", names[*param_threshold_type - 4], *param_adaptive_threshold_size);
 
-		adaptiveThreshold(grayscale, bin, 255, type, THRESH_BINARY, *param_adaptive_threshold_size, *param_threshold - 128);
+			threshold_integral(gray, bin);
+		}
+		else if (*param_threshold_type == 1) { // Binary threshold, user-defined value
+			log.log<log_level::info>("threshold: Using binary threshold %i.\n", *param_threshold);
+			cv::threshold(gray, bin, *param_threshold, 255, THRESH_BINARY);
+		}
+		else {
+			if (*param_threshold_type != 0)
+				log.log<log_level::warning>("threshold: Unknown threshold type specified (%i)!\n", *param_threshold_type);
+			// Binary threshold, calculated value
+			log.log<log_level::info>("threshold: Using Otsu's algorithm\n");
+			cv::threshold(gray, bin, *param_threshold, 255, THRESH_BINARY | THRESH_OTSU);
+		}
+		count_mat(bin);
+		if (*param_interactive)
+			grayscale = gray;
 	}
-	else if (*param_threshold_type == 1) { // Binary threshold, user-defined value
-		log.log<log_level::info>("threshold: Using binary threshold %i.\n", *param_threshold);
-		threshold(grayscale, bin, *param_threshold, 255, THRESH_BINARY);
+}
+
+void thresholder::threshold(const Mat &original, bit_mat &bin) {
+	stage_timer time("threshold");
+	max_image_size = original.cols + original.rows;
+	grayscale.release();
+	binary.release();
+	filled.release();
+
+	if ((*param_threshold_type >= 0) && (*param_threshold_type <= 1) && (original.type() == CV_8UC(3))) { // Global threshold, pack bits while converting bands of rows
+		int band_rows = std::max(1, (32 << 10) / std::max(1, original.cols));
+		Mat gray(band_rows, original.cols, CV_8UC(1));
+		int value = *param_threshold;
+		if (*param_threshold_type == 0) { // Otsu's value from histogram of whole image, bands are converted twice to avoid full size grayscale image
+			std::vector<long> histogram(256, 0);
+			for (int y = 0; y < original.rows; y += band_rows) {
+				int rows = std::min(band_rows, original.rows - y);
+				cvtColor(original.rowRange(y, y + rows), gray.rowRange(0, rows), rgb_order ? CV_BGR2GRAY : CV_RGB2GRAY);
+				for (int i = 0; i < rows; i++) {
+					const uint8_t *row = gray.ptr<uint8_t>(i);
+					for (int j = 0; j < gray.cols; j++)
+						histogram[row[j]]++;
+				}
+			}
+			if (*param_invert_input)
+				std::reverse(histogram.begin(), histogram.end());
+			value = otsu_threshold(histogram);
+			log.log<log_level::info>("threshold: Using Otsu's algorithm (bit-packed output), value %i\n", value);
+		}
+		else
+			log.log<log_level::info>("threshold: Using binary threshold %i (bit-packed output).\n", value);
+
+		uint64_t lut[256];
+		for (int g = 0; g < 256; g++)
+			lut[g] = (((*param_invert_input) ? 255 - g : g) > value) ? 1 : 0;
+		bin.create(original.rows, original.cols);
+		for (int y = 0; y < original.rows; y += band_rows) {
+			int rows = std::min(band_rows, original.rows - y);
+			cvtColor(original.rowRange(y, y + rows), gray.rowRange(0, rows), rgb_order ? CV_BGR2GRAY : CV_RGB2GRAY);
+			for (int i = 0; i < rows; i++) {
+				const uint8_t *row = gray.ptr<uint8_t>(i);
+				uint64_t *out = bin.row(y + i);
+				for (int j = 0; j < gray.cols; j++)
+					out[j >> 6] |= lut[row[j]] << (j & 63);
+			}
+		}
 	}
 	else {
-		if (*param_threshold_type != 0)
-			log.log<log_level::warning>("threshold: Unknown threshold type specified (%i)!\n", *param_threshold_type);
-		// Binary threshold, calculated value
-		log.log<log_level::info>("threshold: Using Otsu's algorithm\n");
-		threshold(grayscale, bin, *param_threshold, 255, THRESH_BINARY | THRESH_OTSU);
+		Mat full;
+		threshold_mat(original, full);
+		bin.from_mat(full);
+	}
+	count_mat(bin);
+
+	// Save image after thresholding
+	if (!param_save_threshold_name->empty()) {
+		Mat image;
+		bin.to_mat(image);
+		imwrite(*param_save_threshold_name, image);
+	}
+}
+
+bool thresholder::bitmap_supported() const {
+	// Black lines only (empty color image is traced as black) and global threshold between black and white
+	return (*param_invert_input == 1) && ((*param_threshold_type == 0) || ((*param_threshold_type == 1) && (*param_threshold < 255)));
+}
+
+void thresholder::from_bitmap(const pnm_image &bitmap, Mat &bin) {
+	stage_timer time("threshold");
+	max_image_size = bitmap.width + bitmap.height;
+	bin = Mat(bitmap.height, bitmap.width, CV_8UC(1));
+	count_mat(bin);
+	int row_bytes = (bitmap.width - 1) / 8 + 1;
+	for (int r = 0; r < bitmap.height; r++) // Black pixels (bit 1) are lines
+		pnm_kernels::unpack_bits(bitmap.data + r*row_bytes, bin.ptr<uint8_t>(r), bitmap.width, 255, 0);
+	log.log<log_level::info>("threshold: Using binary PBM input directly.\n");
+
+	grayscale.release();
+	filled.release();
+	if (*param_interactive) {
+		this->binary = bin.clone();
+		count_mat(this->binary);
+	}
+
+	// Save image after thresholding
+	if (!param_save_threshold_name->empty()) {
+		imwrite(*param_save_threshold_name, bin);
 	}
+}
 
-	this->binary = bin.clone();
+void thresholder::from_bitmap(const pnm_image &bitmap, bit_mat &bin) {
+	stage_timer time("threshold");
+	max_image_size = bitmap.width + bitmap.height;
+	grayscale.release();
+	binary.release();
+	filled.release();
+	bin.create(bitmap.height, bitmap.width);
+	count_mat(bin);
+	int row_bytes = (bitmap.width - 1) / 8 + 1;
+	for (int r = 0; r < bitmap.height; r++) { // Black pixels (bit 1) are lines, PBM has first pixel in highest bit
+		const pnm_data_t *in = bitmap.data + r*row_bytes;
+		uint64_t *out = bin.row(r);
+		for (int k = 0; k < row_bytes; k++) {
+			uint64_t reversed = ((in[k] * 0x0202020202ull) & 0x010884422010ull) % 1023;
+			out[k >> 3] |= reversed << ((k & 7) * 8);
+		}
+		if (bitmap.width & 63) // Clear padding bits
+			out[bitmap.width >> 6] &= ((uint64_t) 1 << (bitmap.width & 63)) - 1;
+	}
+	log.log<log_level::info>("threshold: Using binary PBM input directly (bit-packed output).\n");
 
 	// Save image after thresholding
 	if (!param_save_threshold_name->empty()) {
-		imwrite(*param_save_threshold_name, this->binary);
+		Mat image;
+		bin.to_mat(image);
+		imwrite(*param_save_threshold_name, image);
+	}
+}
+
+void thresholder::filter_components(Mat &bin) {
+	int threads = worker_count(*param_threads, bin.rows);
+	auto small = [](const component &c, int size, int area) {
+		return (size && (c.bbox.width < size) && (c.bbox.height < size)) || (area && (c.pixels < area));
+	};
+	auto apply = [&](const Mat &labels, const std::vector<uint8_t> &change, uint8_t value) { // Set pixels of changed components to value
+		parallel_for(bin.rows, threads, [&](int i, int) {
+			const int32_t *lab = labels.ptr<int32_t>(i);
+			uint8_t *row = bin.ptr<uint8_t>(i);
+			for (int j = 0; j < bin.cols; j++) {
+				if (change[lab[j]])
+					row[j] = value;
+			}
+		});
+	};
+	Mat labels;
+	std::vector<component> list;
+
+	// Holes: 4-connected background components not touching image border
+	if (*param_fill_holes || *param_hole_area) {
+		int count = components::label(bin, labels, list, threads, true);
+		count_mat(labels);
+		std::vector<uint8_t> fill(count + 1, 0);
+		int filled_count = 0;
+		for (int c = 0; c < count; c++) {
+			const Rect &b = list[c].bbox;
+			bool inner = (b.x > 0) && (b.y > 0) && (b.x + b.width < bin.cols) && (b.y + b.height < bin.rows);
+			filled_count += fill[c + 1] = inner && small(list[c], *param_fill_holes, *param_hole_area);
+		}
+		log.log<log_level::info>("filter: %i of %i background components filled\n", filled_count, count);
+		apply(labels, fill, 255);
+	}
+
+	// Dust: 8-connected foreground components
+	if (*param_dust_size || *param_dust_area) {
+		int count = components::label(bin, labels, list, threads);
+		count_mat(labels);
+		std::vector<uint8_t> drop(count + 1, 0);
+		int dropped = 0;
+		for (int c = 0; c < count; c++)
+			dropped += drop[c + 1] = small(list[c], *param_dust_size, *param_dust_area);
+		log.log<log_level::info>("filter: %i of %i components removed\n", dropped, count);
+		apply(labels, drop, 0);
 	}
+}
 
-	// Close objects (remove small holes in thicker lines)
-	if (*param_fill_holes)
-		morphologyEx(bin, bin, MORPH_CLOSE, getStructuringElement(MORPH_ELLIPSE, Size(*param_fill_holes, *param_fill_holes)));
+void thresholder::filter(Mat &bin) {
+	stage_timer time("filter");
+	if (*param_filter_type == 1)
+		filter_components(bin);
+	else {
+		// Close objects (remove small holes in thicker lines)
+		if (*param_fill_holes)
+			morphologyEx(bin, bin, MORPH_CLOSE, getStructuringElement(MORPH_ELLIPSE, Size(*param_fill_holes, *param_fill_holes)));
 
-	// Open objects (remove small points)
-	if (*param_dust_size)
-		morphologyEx(bin, bin, MORPH_OPEN, getStructuringElement(MORPH_ELLIPSE, Size(*param_dust_size, *param_dust_size)));
+		// Open objects (remove small points)
+		if (*param_dust_size)
+			morphologyEx(bin, bin, MORPH_OPEN, getStructuringElement(MORPH_ELLIPSE, Size(*param_dust_size, *param_dust_size)));
+	}
 
 	// Save image after filling
 	if (!param_save_filled_name->empty()) {
 		imwrite(*param_save_filled_name, bin);
 	}
 
-	this->filled = bin;
+	if (*param_interactive)
+		this->filled = bin;
 }
 
 void thresholder::interactive(TrackbarCallback onChange, void *userdata) {
+#ifndef VECTORIX_HEADLESS
 	zoom_imshow("Grayscale", grayscale); // Show grayscale input image
 	zoom_imshow("Threshold", binary); // Show after thresholding
 	zoom_imshow("Filled", filled); // Show after filling
 
 	createTrackbar("Invert input", "Grayscale", param_invert_input, 1, onChange, userdata);
-	createTrackbar("Threshold type", "Threshold", param_threshold_type, 3, onChange, userdata);
+	createTrackbar("Threshold type", "Threshold", param_threshold_type, 6, onChange, userdata);
 	createTrackbar("Threshold", "Threshold", param_threshold, 255, onChange, userdata);
 	createTrackbar("Adaptive threshold", "Threshold", param_adaptive_threshold_size, max_image_size, onChange, userdata);
 	createTrackbar("Filling size", "Filled", param_fill_holes, 50, onChange, userdata);
 	createTrackbar("Dust removal size", "Filled", param_dust_size, 50, onChange, userdata);
+	createTrackbar("Filter type", "Filled", param_filter_type, 1, onChange, userdata);
 	waitKey(1);
+#endif
 };
 
 }; // namespace
@@ -6,8 +6,12 @@
 #define VECTORIX__THRESHOLDER_H
 
 #include <opencv2/opencv.hpp>
+#include <vector>
+#include <string>
 #include "parameters.h"
+#include "pnm_handler.h"
 #include "logger.h"
+#include "bit_mat.h"
 
 namespace vectorix {
 
@@ -21,38 +25,79 @@ public:
 		par->add_comment("Phase 1: Thresholding");
 		par->add_comment("Invert colors: 0: white lines, 1: black lines");
 		par->bind_param(param_invert_input, "invert_colors", 1);
-		par->add_comment("Threshold type: 0: Otsu's algorithm, 1: Fixed value");
+		par->add_comment("Threshold type: 0: Otsu's algorithm, 1: Fixed value, 2: Adaptive gaussian, 3: Adaptive mean,");
+		par->add_comment("  4: Adaptive mean (integral image), 5: Sauvola (integral image), 6: Niblack (integral image)");
 		par->bind_param(param_threshold_type, "threshold_type", 0);
 		par->add_comment("Threshold value: 0-255");
 		par->bind_param(param_threshold, "threshold", 127);
 		par->add_comment("Adaptive threshold size: 3, 5, 7, ...");
 		par->bind_param(param_adaptive_threshold_size, "adaptive_threshold_size", 7);
+		par->add_comment("Sauvola and Niblack: weight of standard deviation in window");
+		par->bind_param(param_adaptive_threshold_k, "adaptive_threshold_k", (p) 0.2);
+		par->add_comment("Sauvola: dynamic range of standard deviation");
+		par->bind_param(param_adaptive_threshold_range, "adaptive_threshold_range", (p) 128);
 		par->add_comment("Save thresholded image to file: empty: no output");
 		par->bind_param(param_save_threshold_name, "file_threshold_output", (std::string) "");
+		par->add_comment("Filter type: 0: morphology (elliptical closing and opening), 1: connected components (line shapes are kept)");
+		par->bind_param(param_filter_type, "filter_type", 0);
 		par->add_comment("Fill holes (of given size) in lines: 0 = no filling");
 		par->bind_param(param_fill_holes, "fill_holes", 0);
 		par->add_comment("Remove dust (with smaller grains): 0 = no change");
 		par->bind_param(param_dust_size, "dust_size", 0);
+		par->add_comment("Connected components: fill holes / remove dust with area smaller than given count of pixels, 0 = no limit");
+		par->bind_param(param_hole_area, "hole_area", 0);
+		par->bind_param(param_dust_area, "dust_area", 0);
 		par->add_comment("Save image with filled holes (and removed dust) to file: empty = no output");
 		par->bind_param(param_save_filled_name, "file_filled_output", (std::string) "");
+		par->bind_param(param_interactive, "interactive", 1);
+		par->bind_param(param_threads, "threads", 0);
 	}
-	void run(const cv::Mat &original, cv::Mat &binary);
+	void run(const cv::Mat &original, cv::Mat &binary); // threshold() and filter()
+	void threshold(const cv::Mat &original, cv::Mat &binary); // Only thresholding
+	void filter(cv::Mat &binary); // Fill holes and remove dust in thresholded image
+	bool bitmap_supported() const; // threshold() of bitmap gives the same result as from_bitmap()
+	void from_bitmap(const pnm_image &bitmap, cv::Mat &binary); // Unpack binary PBM instead of threshold(), no grayscale image is created
+	void threshold(const cv::Mat &original, bit_mat &binary); // Bit-packed output (nothing is kept for interactive windows)
+	void from_bitmap(const pnm_image &bitmap, bit_mat &binary);
+	bool filter_enabled() const { return *param_fill_holes || *param_dust_size || ((*param_filter_type == 1) && (*param_hole_area || *param_dust_area)); }; // filter() changes image (it works only with 8bit images)
 	void interactive(cv::TrackbarCallback onChange = 0, void *userdata = 0);
 
+	void to_grayscale(const cv::Mat &original, cv::Mat &gray); // Convert to grayscale, invert if requested
+	void set_rgb_order(bool rgb) { rgb_order = rgb; }; // Color images are RGB (wrapped PNM data), default is BGR (OpenCV)
+	static int otsu_threshold(const std::vector<long> &histogram); // Same value as OpenCV's THRESH_OTSU on image with given histogram
+
+	static const std::vector<std::string> threshold_params; // Parameters which change output of threshold()
+	static const std::vector<std::string> filter_params; // Parameters which change output of filter()
+	static const std::vector<std::string> used_params; // Parameters which change output of run()
+
 private:
 	int *param_invert_input;
 	int *param_threshold_type;
 	int *param_threshold;
 	int *param_adaptive_threshold_size;
+	p *param_adaptive_threshold_k;
+	p *param_adaptive_threshold_range;
 	std::string *param_save_threshold_name;
+	int *param_filter_type;
 	int *param_fill_holes;
 	int *param_dust_size;
+	int *param_hole_area;
+	int *param_dust_area;
 	std::string *param_save_filled_name;
+	int *param_interactive;
+	int *param_threads;
+
+	void threshold_mat(const cv::Mat &original, cv::Mat &binary); // threshold() without saving and copies for windows
+	void threshold_fused(const cv::Mat &original, cv::Mat &binary); // Grayscale, inversion and global threshold in one pass over bands of rows
+	void threshold_integral(const cv::Mat &gray, cv::Mat &binary); // Adaptive threshold from window statistics, any window size in constant time per pixel
+	void filter_components(cv::Mat &binary); // Fill holes and remove dust by size of connected components
 
 	logger log;
 	parameters *par;
 
-	cv::Mat grayscale;
+	bool rgb_order = false;
+
+	cv::Mat grayscale; // Images of last run, kept only for interactive windows
 	cv::Mat binary;
 	cv::Mat filled;
 	int max_image_size;
@@ -0,0 +1,126 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include "parameters.h"
+#include "logger.h"
+#include "v_image.h"
+#include "tiler.h"
+#include "stitcher.h"
+#include "parallel.h"
+
+// Tiled processing of large images
+
+using namespace cv;
+
+namespace vectorix {
+
+int tiler::halo() {
+	int size = *param_max_stroke_width + 2 * std::ceil(*param_nearby_limit) + 2; // Skeleton and tracing near the seam see the same neighbourhood as without tiles
+	int filter = std::max(*param_fill_holes, *param_dust_size);
+	if (*param_filter_type == 1) // Component with area under limit is also narrower than the limit
+		filter = std::max(filter, std::max(*param_hole_area, *param_dust_area));
+	size += filter;
+	if ((*param_threshold_type >= 2) && (*param_threshold_type <= 6)) // Adaptive thresholds
+		size += *param_adaptive_threshold_size / 2;
+	return size;
+}
+
+Rect tiler::tile_core(const Mat &original, int tile) {
+	int size = *param_tile_size;
+	int columns = (original.cols + size - 1) / size;
+	int x = (tile % columns) * size;
+	int y = (tile / columns) * size;
+	return Rect(x, y, std::min(size, original.cols - x), std::min(size, original.rows - y));
+}
+
+void tiler::run(const Mat &original, v_image &output) {
+	stage_timer time("tiles");
+	int size = *param_tile_size;
+	int count = ((original.cols + size - 1) / size) * ((original.rows + size - 1) / size);
+	int border = halo();
+	int threads = worker_count(*param_threads, count);
+	log.log<log_level::info>("Tiles: %i tiles of %ix%i px, halo %i px, %i threads\n", count, size, size, border, threads);
+
+	// Every thread has its own stages, tracer changes its parameters while running
+	std::vector<std::unique_ptr<worker>> workers;
+	for (int w = 0; w < threads; w++) {
+		workers.emplace_back(new worker(*par));
+		workers.back()->thr.set_rgb_order(rgb_order);
+		workers.back()->tra.set_rgb_order(rgb_order);
+		parameters &wpar = workers.back()->par;
+		for (const char *name: {"file_threshold_output", "file_filled_output", "files_steps_output", "file_skeleton", "file_distance", "file_skeleton_norm", "file_distance_norm"}) {
+			std::string *save_name;
+			wpar.bind_param(save_name, name, (std::string) "");
+			save_name->clear(); // All tiles would write to the same file
+		}
+	}
+
+	if (*param_threshold_type == 0) { // Otsu's threshold has to be the same in all tiles
+		std::vector<std::vector<long>> histograms(threads, std::vector<long>(256, 0));
+		parallel_for(count, threads, [&](int tile, int w) {
+			Mat gray;
+			workers[w]->thr.to_grayscale(original(tile_core(original, tile)), gray);
+			for (int i = 0; i < gray.rows; i++) {
+				const uint8_t *row = gray.ptr<uint8_t>(i);
+				for (int j = 0; j < gray.cols; j++)
+					histograms[w][row[j]]++;
+			}
+		});
+		for (int w = 1; w < threads; w++) {
+			for (int i = 0; i < 256; i++)
+				histograms[0][i] += histograms[w][i];
+		}
+		int value = thresholder::otsu_threshold(histograms[0]);
+		log.log<log_level::info>("Tiles: Otsu's threshold for whole image: %i\n", value);
+		for (auto &w: workers) {
+			int *type, *threshold;
+			w->par.bind_param(type, "threshold_type", 0);
+			w->par.bind_param(threshold, "threshold", 127);
+			*type = 1; // Fixed value
+			*threshold = value;
+		}
+	}
+
+	std::vector<std::vector<line_fragment>> fragments(count);
+	parallel_for(count, threads, [&](int tile, int w) {
+		Rect core = tile_core(original, tile);
+		Rect roi(std::max(0, core.x - border), std::max(0, core.y - border), 0, 0);
+		roi.width = std::min(original.cols, core.x + core.width + border) - roi.x;
+		roi.height = std::min(original.rows, core.y + core.height + border) - roi.y;
+
+		metrics_scope scope(&workers[w]->met);
+		Mat tile_image = original(roi); // No copy
+		Mat binary, skeleton, distance;
+		v_image traced(roi.width, roi.height);
+		workers[w]->thr.run(tile_image, binary);
+		workers[w]->ske.run(binary, skeleton, distance);
+		workers[w]->tra.run(tile_image, skeleton, distance, traced);
+
+		for (v_line &line: traced.line) { // Keep only parts of lines in tile core
+			stitcher::shift(line, v_pt(roi.x, roi.y));
+			stitcher::cut(line, core.x, core.y, core.x + core.width, core.y + core.height, tile, fragments[tile]);
+		}
+		log.log<log_level::debug>("Tiles: tile %i traced, %i fragments\n", tile, fragments[tile].size());
+	});
+
+	if (metrics *m = metrics::current()) {
+		for (auto &w: workers)
+			m->merge(w->met);
+	}
+
+	std::vector<line_fragment> all;
+	for (auto &f: fragments)
+		all.insert(all.end(), f.begin(), f.end());
+	fragments.clear();
+	output.clean();
+	stitcher::stitch(all, 2 * *param_nearby_limit, output);
+	log.log<log_level::debug>("Tiles: %i fragments stitched to %i lines\n", all.size(), output.line.size());
+}
+
+}; // namespace
@@ -0,0 +1,86 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#ifndef VECTORIX__TILER_H
+#define VECTORIX__TILER_H
+
+// Tiled processing of large images: threshold, skeletonize and trace each
+// tile (with overlapping halo) separately and stitch lines at tile seams.
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "parameters.h"
+#include "logger.h"
+#include "v_image.h"
+#include "thresholder.h"
+#include "skeletonizer.h"
+#include "tracer.h"
+#include "metrics.h"
+
+namespace vectorix {
+
+class tiler {
+public:
+	tiler(parameters &params): par(&params) {
+		int *param_vectorizer_verbosity;
+		par->bind_param(param_vectorizer_verbosity, "vectorizer_verbosity", (int) log_level::warning);
+		log.set_verbosity((log_level) *param_vectorizer_verbosity);
+
+		par->add_comment("Tiled processing (only without interactive mode): tile size in pixels, 0 = whole image at once");
+		par->bind_param(param_tile_size, "tile_size", 0);
+		par->add_comment("Maximal stroke width in pixels, tiles overlap by this width plus tracing neighbourhood");
+		par->bind_param(param_max_stroke_width, "max_stroke_width", 32);
+		par->add_comment("Worker threads used for one image: 0 = number of cores");
+		par->bind_param(param_threads, "threads", 0);
+
+		par->bind_param(param_threshold_type, "threshold_type", 0);
+		par->bind_param(param_threshold, "threshold", 127);
+		par->bind_param(param_adaptive_threshold_size, "adaptive_threshold_size", 7);
+		par->bind_param(param_fill_holes, "fill_holes", 0);
+		par->bind_param(param_dust_size, "dust_size", 0);
+		par->bind_param(param_filter_type, "filter_type", 0);
+		par->bind_param(param_hole_area, "hole_area", 0);
+		par->bind_param(param_dust_area, "dust_area", 0);
+		par->bind_param(param_nearby_limit, "nearby_limit", (p) 10);
+	};
+	bool enabled() const { return *param_tile_size > 0; };
+	void run(const cv::Mat &original, v_image &output); // Threshold, skeletonize and trace whole image tile by tile
+	void set_rgb_order(bool rgb) { rgb_order = rgb; }; // Original is RGB (wrapped PNM data), default is BGR (OpenCV)
+private:
+	int *param_tile_size;
+	int *param_max_stroke_width;
+	int *param_threads;
+
+	int *param_threshold_type;
+	int *param_threshold;
+	int *param_adaptive_threshold_size;
+	int *param_fill_holes;
+	int *param_dust_size;
+	int *param_filter_type;
+	int *param_hole_area;
+	int *param_dust_area;
+	p *param_nearby_limit;
+
+	bool rgb_order = false;
+
+	class worker { // Stages with private parameters for one thread
+	public:
+		worker(const parameters &params): par(params), thr(par), ske(par), tra(par) {};
+		parameters par;
+		thresholder thr;
+		skeletonizer ske;
+		tracer tra;
+		metrics met; // Counters of this thread, merged after all tiles are done
+	};
+
+	int halo(); // Overlap of tiles
+	cv::Rect tile_core(const cv::Mat &original, int tile); // Part of image owned by given tile
+
+	logger log;
+	parameters *par;
+};
+
+}; // namespace
+
+#endif
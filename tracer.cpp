@@ -3,17 +3,30 @@
  * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
  */
 #include <opencv2/opencv.hpp>
+#include <vector>
+#include <string>
 #include "parameters.h"
 #include "logger.h"
 #include "tracer.h"
 #include "tracer_helper.h"
 #include "geom.h"
+#include "metrics.h"
 
 using namespace cv;
 
 namespace vectorix {
 
+const std::vector<std::string> tracer::used_params = {"depth_auto_choose", "max_dfs_depth", "nearby_limit", "nearby_limit_gauss", "distance_coef", "gauss_precision", "angle_steps", "angular_precision", "size_nearby_smooth", "max_angle_search_smooth", "nearby_control_smooth", "smoothness", "param_min_nearby_straight", "tracer_parallel", "tracer_split_size"};
+
 void tracer::run(const cv::Mat &color_input, const cv::Mat &skeleton, const cv::Mat &distance, v_image &vectorization_output) {
+	stage_timer time("tracing");
+	if (*param_tracer_parallel) {
+		run_parallel(color_input, skeleton, distance, vectorization_output);
+		return;
+	}
+	prediction_count = 0;
+	fitness_pixel_count = 0;
+
 	vectorization_output.clean();
 	lab_skel = labeled_Mat(*par);
 	lab_skel.init(skeleton);
@@ -51,6 +64,10 @@ void tracer::run(const cv::Mat &color_input, const cv::Mat &skeleton, const cv::
 		max = lab_skel.get_max_unlabeled(max_pos); // Get next possible starting point
 	}
 	log.log<log_level::debug>("lines found: %i\n", count);
+
+	vectorix::count(counter::start_points, count);
+	vectorix::count(counter::predictions, prediction_count);
+	vectorix::count(counter::fitness_pixels, fitness_pixel_count);
 }
 
 //void tracer::interactive(TrackbarCallback onChange, void *userdata) {
@@ -179,6 +196,7 @@ v_pt tracer::find_best_gaussian(v_pt center, p size) { // Find best value in giv
 p tracer::calculate_line_fitness(v_pt center, v_pt end, p min_dist, p max_dist) { // Calculate how 'good' is given line
 	Point corner1(center.x - max_dist, center.y - max_dist); // Upper left corner
 	Point corner2(center.x + max_dist + 1, center.y + max_dist + 1); // Lower right corner
+	fitness_pixel_count += (long) (corner2.y - corner1.y) * (corner2.x - corner1.x);
 	p res = 0;
 	for (int i = corner1.y; i < corner2.y; i++) {
 		for (int j = corner1.x; j < corner2.x; j++) { // for every pixel in rectangle
@@ -396,6 +414,7 @@ void tracer::find_best_variant(const match_variant &last, const v_line &line, st
 }
 
 p tracer::do_prediction(const match_variant &last_placed, int allowed_depth, v_line &line, match_variant &new_point) {
+	prediction_count++;
 	if (allowed_depth <= 0) {
 		return 0;
 	}
@@ -439,15 +458,17 @@ p tracer::do_prediction(const match_variant &last_placed, int allowed_depth, v_l
  * accesing image data (1)
  */
 
-v_co tracer::safeat_co(const Mat &image, int i, int j) { // Safely access rgb image data
+v_co tracer::safeat_co(const Mat &image, int i, int j) { // Safely access rgb image data (empty image = black lines of bitmap input)
 	if (i>=0 && i<image.rows && j>=0 && j<image.cols)
-		return v_co(image.at<Vec3b>(i, j)[2], image.at<Vec3b>(i, j)[1], image.at<Vec3b>(i, j)[0]);
+		return v_co(image.at<Vec3b>(i, j)[red], image.at<Vec3b>(i, j)[1], image.at<Vec3b>(i, j)[blue]);
 	else {
 		return v_co(0, 0, 0); // Pixel is outside of image
 	}
 }
 
 v_co tracer::apxat_co(const Mat &image, v_pt pt) { // Get rgb at non-integer position (aproximate from neighbors)
+	if (color_scale > 1) // Position in downsampled image
+		pt = (pt + color_offset) / color_scale;
 	int x = pt.x - 0.5f;
 	int y = pt.y - 0.5f;
 	pt.x-=x+0.5f;
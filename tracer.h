@@ -11,6 +11,7 @@
 #include "logger.h"
 #include "tracer_helper.h"
 #include <vector>
+#include <string>
 
 namespace vectorix {
 
@@ -56,10 +57,22 @@ public:
 		par->bind_param(param_nearby_control_smooth, "nearby_control_smooth", (p) 5);
 		par->bind_param(param_smoothness, "smoothness", (p) 0.5);
 		par->bind_param(param_min_nearby_straight, "param_min_nearby_straight", (p) 0);
+
+		par->add_comment("Parallel tracing: 0: off, 1: trace independent skeleton components on worker threads");
+		par->bind_param(param_tracer_parallel, "tracer_parallel", 0);
+		par->add_comment("Parallel tracing: split components larger than given size (in pixels) and stitch them, 0 = never split");
+		par->bind_param(param_tracer_split_size, "tracer_split_size", 1024);
+		par->add_comment("Worker threads used for one image: 0 = number of cores");
+		par->bind_param(param_threads, "threads", 0);
 	}
-	void run(const cv::Mat &color_input, const cv::Mat &skeleton, const cv::Mat &distance, v_image &vectorization_output); // Trace skeleton
+	void run(const cv::Mat &color_input, const cv::Mat &skeleton, const cv::Mat &distance, v_image &vectorization_output); // Trace skeleton, empty color_input = black lines
+	void set_rgb_order(bool rgb) { red = rgb ? 0 : 2; blue = rgb ? 2 : 0; }; // Color input is RGB (wrapped PNM data), default is BGR (OpenCV)
+	void set_color_scale(int scale, v_pt offset = v_pt(0, 0)) { color_scale = scale; color_offset = offset; }; // Color input is downsampled, skeleton starts at offset of full size image
 	//void interactive(cv::TrackbarCallback onChange = 0, void *userdata = 0);
 
+	static const std::vector<std::string> used_params; // Parameters which change output of run()
+
+	friend class tracer_bench; // Micro-benchmarks of private kernels (bench.cpp)
 private:
 	p *param_depth_auto_choose;
 	int *param_max_dfs_depth;
@@ -76,6 +89,13 @@ private:
 	p *param_smoothness;
 	p *param_min_nearby_straight;
 
+	int *param_tracer_parallel;
+	int *param_tracer_split_size;
+	int *param_threads;
+
+	// Trace groups of skeleton components (far enough from each other) in parallel, see tracer_parallel.cpp
+	void run_parallel(const cv::Mat &color_input, const cv::Mat &skeleton, const cv::Mat &distance, v_image &vectorization_output);
+
 	void trace_part(cv::Point startpoint, v_line &line); // Trace one line
 
 	/*
@@ -114,7 +134,15 @@ private:
 
 	// Pixels used by tracing are labeled
 	labeled_Mat lab_skel;
+
+	// Work counters of current run (see metrics.h)
+	long prediction_count;
+	long fitness_pixel_count;
 	cv::Mat color;
+	int red = 2; // Channel indices in color
+	int blue = 0;
+	int color_scale = 1; // Color pixel covers color_scale x color_scale pixels of skeleton
+	v_pt color_offset;
 	cv::Mat dist;
 };
 
@@ -6,6 +6,7 @@
 #include "parameters.h"
 #include "logger.h"
 #include "tracer_helper.h"
+#include "metrics.h"
 
 using namespace cv;
 
@@ -143,6 +144,7 @@ void labeled_Mat::init(const cv::Mat &mat) {
 	int rows = mat.rows;
 	int cols = mat.cols;
 	label = Mat::zeros(rows, cols, CV_8UC(1));
+	count_mat(label);
 
 	// Speedup label removing using OpenCV region of interest
 	changed_roi.clear(cols, rows);
@@ -0,0 +1,153 @@
+/*
+ * Vectorix -- line-based image vectorizer
+ * (c) 2016 Jan Hadrava <had@atrey.karlin.mff.cuni.cz>
+ */
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include "parameters.h"
+#include "logger.h"
+#include "v_image.h"
+#include "tracer.h"
+#include "components.h"
+#include "stitcher.h"
+#include "parallel.h"
+#include "metrics.h"
+
+// Parallel tracing of independent skeleton components
+//
+// Tracer never reaches further than nearby limit (plus smoothing) and line
+// width from a traced point, components further apart are traced separately.
+// Every group of near components is one task (or more tasks for large groups,
+// these are joined by stitcher like tiles). Output order depends only on
+// input image, not on count of threads.
+
+using namespace cv;
+
+namespace vectorix {
+
+void tracer::run_parallel(const Mat &color_input, const Mat &skeleton, const Mat &distance, v_image &vectorization_output) {
+	vectorization_output.clean();
+
+	Mat labels;
+	std::vector<component> list;
+	int count = components::label(skeleton, labels, list);
+
+	int max_width = 0;
+	for (int i = 0; i < skeleton.rows; i++) {
+		for (int j = 0; j < skeleton.cols; j++) {
+			if (skeleton.at<uint8_t>(i, j))
+				max_width = std::max(max_width, distance.at<int32_t>(i, j));
+		}
+	}
+	int margin = std::ceil(*param_nearby_limit + *param_size_nearby_smooth) + max_width + 2;
+
+	std::vector<int> group_of;
+	int groups = components::group(list, margin, group_of);
+	std::vector<Rect> group_box(groups);
+	std::vector<bool> group_used(groups, false);
+	for (int c = 0; c < count; c++) {
+		int g = group_of[c];
+		group_box[g] = group_used[g] ? (group_box[g] | list[c].bbox) : list[c].bbox;
+		group_used[g] = true;
+	}
+
+	class task {
+	public:
+		int group;
+		Rect core; // Lines are kept only inside (if group is split)
+	};
+	std::vector<task> tasks;
+	std::vector<int> first_task(groups + 1);
+	int split = *param_tracer_split_size;
+	for (int g = 0; g < groups; g++) {
+		first_task[g] = tasks.size();
+		const Rect &box = group_box[g];
+		if ((split > 0) && ((box.width > split) || (box.height > split))) {
+			for (int y = box.y; y < box.y + box.height; y += split) {
+				for (int x = box.x; x < box.x + box.width; x += split)
+					tasks.push_back({g, Rect(x, y, std::min(split, box.x + box.width - x), std::min(split, box.y + box.height - y))});
+			}
+		}
+		else
+			tasks.push_back({g, box});
+	}
+	first_task[groups] = tasks.size();
+
+	int threads = worker_count(*param_threads, tasks.size());
+	log.log<log_level::info>("Tracing: %i components in %i groups, %i tasks, %i threads\n", count, groups, tasks.size(), threads);
+
+	class worker { // Tracer with private parameters for one thread
+	public:
+		worker(const parameters &params): par(params), tra(par) {};
+		parameters par;
+		tracer tra;
+		metrics met; // Counters of this thread, merged after all tasks are done
+	};
+	std::vector<std::unique_ptr<worker>> workers;
+	for (int w = 0; w < threads; w++) {
+		workers.emplace_back(new worker(*par));
+		workers.back()->tra.set_rgb_order(red == 0);
+		workers.back()->tra.set_color_scale(color_scale);
+		int *parallel;
+		workers.back()->par.bind_param(parallel, "tracer_parallel", 0);
+		*parallel = 0;
+	}
+
+	std::vector<std::vector<line_fragment>> fragments(tasks.size());
+	parallel_for(tasks.size(), threads, [&](int t, int w) {
+		metrics_scope scope(&workers[w]->met);
+		const task &ta = tasks[t];
+		Rect roi(std::max(0, ta.core.x - margin), std::max(0, ta.core.y - margin), 0, 0);
+		roi.width = std::min(skeleton.cols, ta.core.x + ta.core.width + margin) - roi.x;
+		roi.height = std::min(skeleton.rows, ta.core.y + ta.core.height + margin) - roi.y;
+
+		Mat skel = skeleton(roi).clone(); // Only pixels of this group
+		for (int i = 0; i < skel.rows; i++) {
+			const int32_t *lab = labels.ptr<int32_t>(roi.y + i) + roi.x;
+			uint8_t *row = skel.ptr<uint8_t>(i);
+			for (int j = 0; j < skel.cols; j++) {
+				if (lab[j] && (group_of[lab[j] - 1] != ta.group))
+					row[j] = 0;
+			}
+		}
+
+		v_image traced(roi.width, roi.height);
+		if (color_scale > 1) // Downsampled color image is shared, tracer shifts positions
+			workers[w]->tra.set_color_scale(color_scale, color_offset + v_pt(roi.x, roi.y));
+		workers[w]->tra.run((color_input.empty() || (color_scale > 1)) ? color_input : color_input(roi), skel, distance(roi), traced);
+		bool whole = first_task[ta.group + 1] - first_task[ta.group] == 1;
+		for (v_line &line: traced.line) {
+			stitcher::shift(line, v_pt(roi.x, roi.y));
+			if (whole) {
+				fragments[t].emplace_back();
+				fragments[t].back().line = line;
+			}
+			else
+				stitcher::cut(line, ta.core.x, ta.core.y, ta.core.x + ta.core.width, ta.core.y + ta.core.height, t, fragments[t]);
+		}
+	});
+
+	if (metrics *m = metrics::current()) {
+		for (auto &w: workers)
+			m->merge(w->met);
+	}
+
+	for (int g = 0; g < groups; g++) { // Merge in order of groups
+		if (first_task[g + 1] - first_task[g] == 1) {
+			for (line_fragment &f: fragments[first_task[g]])
+				vectorization_output.add_line(f.line);
+		}
+		else {
+			std::vector<line_fragment> all;
+			for (int t = first_task[g]; t < first_task[g + 1]; t++)
+				all.insert(all.end(), fragments[t].begin(), fragments[t].end());
+			stitcher::stitch(all, 2 * *param_nearby_limit, vectorization_output);
+		}
+	}
+	log.log<log_level::debug>("lines found: %i\n", vectorization_output.line.size());
+}
+
+}; // namespace
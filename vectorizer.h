@@ -18,6 +18,7 @@ namespace vectorix {
 class vectorizer {
 public:
 	virtual v_image vectorize(const pnm_image &image) = 0;
+	virtual ~vectorizer() = default;
 protected:
 	vectorizer(parameters &params): par(&params) {
 		int *param_vectorizer_verbosity;
@@ -20,7 +20,15 @@
 #include "skeletonizer.h"
 #include "tracer.h"
 #include "approximation.h"
+#ifndef VECTORIX_HEADLESS
 #include "zoom_window.h"
+#endif
+#include "tiler.h"
+#include "stage_cache.h"
+#include "stage_graph.h"
+#include "bit_mat.h"
+#include "metrics.h"
+#include "stream_decoder.h"
 
 // Vectorizer
 
@@ -28,8 +36,8 @@ using namespace cv;
 
 namespace vectorix {
 
-int vectorizer_vectorix::interactive(int state, int key) { // Process key press and decide what to do
-	int ret = state;
+int vectorizer_vectorix::interactive(int stage, int key, stage_graph &graph) { // Process key press and decide which stage should be shown
+	int ret = stage;
 	switch (key & ((2 << 16) - 1)) {
 		case 0:
 		case 0xFF:
@@ -42,11 +50,12 @@ int vectorizer_vectorix::interactive(int state, int key) { // Process key press
 		case 'q':
 		case 'Q':
 		case 27: // Esc
-			ret = 0; // Quit program
+			ret = -1; // Quit program
 			break;
 		case 'r':
 		case 'R':
-			ret = 1; // Rerun from step 1
+			graph.invalidate(0); // Rerun from first stage
+			ret = 0;
 			break;
 		case '\n':
 			ret++; // Next vectorization step
@@ -64,109 +73,190 @@ int vectorizer_vectorix::interactive(int state, int key) { // Process key press
 	return ret;
 }
 
-void vectorizer_vectorix::step1_changed(int, void *ptr) { // Parameter in step 1 changed, rerun
-	volatile int *state = static_cast<volatile int *> (ptr);
-	*state = 2; // first step
+void vectorizer_vectorix::params_changed(int, void *ptr) { // Some trackbar moved, find stale stages later
+	volatile bool *changed = static_cast<volatile bool *> (ptr);
+	*changed = true;
 }
 
-void vectorizer_vectorix::step2_changed(int, void *ptr) { // Parameter in step 2 changed, rerun from this state
-	volatile int *state = static_cast<volatile int *> (ptr);
-	if (*state >= 4)
-		*state = 2; // second step
+void vectorizer_vectorix::pnm_to_mat(const pnm_image &original, Mat &mat) {
+	// Original should be PPM image (color), OpenCV header only points to its data
+	mat = Mat(original.height, original.width, CV_8UC(3), original.data);
 }
 
 void vectorizer_vectorix::load_image(const pnm_image &original) {
-	// Original should be PPM image (color)
-	orig = Mat(original.height, original.width, CV_8UC(3));
+	stage_timer time("load");
 	if (param_custom_input_name->empty()) {
-		for (int j = 0; j < original.height; j++) { // Copy data from PNM image to OpenCV image structures
-			for (int i = 0; i<original.width; i++) {
-				orig.at<Vec3b>(j, i)[2] = original.data[(i+j*original.width)*3 + 0];
-				orig.at<Vec3b>(j, i)[1] = original.data[(i+j*original.width)*3 + 1];
-				orig.at<Vec3b>(j, i)[0] = original.data[(i+j*original.width)*3 + 2];
-			}
+		orig_rgb = true;
+		if (original.type == pnm_variant_type::binary_ppm)
+			pnm_to_mat(original, orig); // No copy, original outlives vectorization
+		else { // Input was not converted by caller (binary PBM)
+			pnm_image color = original;
+			color.convert(pnm_variant_type::binary_ppm);
+			pnm_to_mat(color, orig);
+			orig = orig.clone();
+			count_mat(orig);
 		}
 	}
 	else {
 		// Configuration tell us to read image from file directly by OpenCV
+		orig_rgb = false;
 		orig = imread(*param_custom_input_name, CV_LOAD_IMAGE_COLOR);
 		if (!orig.data) {
 			log.log<log_level::error>("Unable to read image from file \"%s\"\n", param_custom_input_name->c_str());
 			throw("Unable to read input image");
 		}
+		count_mat(orig);
 	}
 }
 
-v_image vectorizer_vectorix::vectorize(const pnm_image &original) {
-	load_image(original);
+#ifndef VECTORIX_HEADLESS
+void vectorizer_vectorix::vectorize_interactive(thresholder &thr, skeletonizer &ske, tracer &tra, approximation &apx, v_image &vect) {
+	// Stages with intermediate results, moving a trackbar reruns only stages using changed parameter
+	volatile bool changed = false;
+	Mat thresholded;
+	v_image traced(orig.cols, orig.rows); // Copied to vect with its dimensions
+	stage_graph graph(*par);
+	int threshold_stage = graph.add("Threshold", thresholder::threshold_params, [&]() {
+		thr.threshold(orig, thresholded);
+	});
+	int filter_stage = graph.add("Filtering", thresholder::filter_params, [&]() {
+		binary = thresholded.clone();
+		thr.filter(binary);
+		thr.interactive(params_changed, (void*) &changed);
+	}, {threshold_stage});
+	int skeleton_stage = graph.add("Skeletonization", skeletonizer::used_params, [&]() {
+		ske.run(binary, skeleton, distance); // Second step -- skeletonization
+		ske.interactive(params_changed, (void*) &changed);
+	}, {filter_stage});
+	int tracing_stage = graph.add("Tracing", tracer::used_params, [&]() {
+		tra.run(orig, skeleton, distance, traced);
+	}, {skeleton_stage});
+	graph.add("Approximation", approximation::used_params, [&]() {
+		vect = traced; // Keep traced image, approximation can be rerun alone
+		apx.run(vect);
+	}, {tracing_stage});
 
-	v_image vect = v_image(orig.cols, orig.rows); // Vector output
+	Mat shown = orig;
+	if (orig_rgb)
+		cvtColor(orig, shown, CV_RGB2BGR);
+	zoom_imshow("Original", shown, true); // Show original color image
+	waitKey(1);
+
+	int stage = filter_stage; // Last stage requested by user, thresholding is shown together with filtering
+	while ((stage >= 0) && (stage < graph.size())) {
+		graph.update(stage);
+
+		int key = waitKey(1);
+		if (changed) {
+			changed = false;
+			graph.check();
+		}
+		if (key >= 0) {
+			log.log<log_level::debug>("Key: %i\n", key);
+			stage = interactive(stage, key, graph);
+			if (stage == threshold_stage)
+				stage = filter_stage;
+		}
+	}
+}
+#else
+void vectorizer_vectorix::vectorize_interactive(thresholder &thr, skeletonizer &ske, tracer &tra, approximation &apx, v_image &vect) { // There are no windows in headless build
+	log.log<log_level::warning>("Interactive mode is not available in headless build.\n");
+	thr.run(orig, binary);
+	ske.run(binary, skeleton, distance);
+	tra.run(orig, skeleton, distance, vect);
+	apx.run(vect);
+}
+#endif
+
+v_image vectorizer_vectorix::vectorize_stream(FILE *fd) {
+	stream_decoder dec(*par);
+	thresholder thr(*par);
+	skeletonizer ske(*par);
+	tracer tra(*par);
+	approximation apx(*par);
+
+	dec.run(fd, binary, orig);
+	orig_rgb = true;
+	v_image vect = v_image(binary.cols, binary.rows);
+	thr.filter(binary);
+	ske.run(binary, skeleton, distance);
+	tra.set_rgb_order(orig_rgb);
+	tra.set_color_scale(dec.color_scale());
+	tra.run(orig, skeleton, distance, vect);
+	apx.run(vect);
+	return vect;
+}
+
+v_image vectorizer_vectorix::vectorize(const pnm_image &original) {
 	thresholder thr(*par);
 	skeletonizer ske(*par);
 	tracer tra(*par);
 	approximation apx(*par);
+	tiler til(*par);
+	stage_cache cache(*par);
+
+	if ((original.type == pnm_variant_type::binary_pbm) && param_custom_input_name->empty() && !*param_interactive && !til.enabled() && !cache.enabled() && thr.bitmap_supported()) {
+		// Bilevel input: bits are unpacked directly to binary image, no color image is needed (lines are black)
+		v_image vect = v_image(original.width, original.height);
+		if (thr.filter_enabled() || !ske.bits_supported()) {
+			thr.from_bitmap(original, binary);
+			thr.filter(binary);
+			ske.run(binary, skeleton, distance);
+		}
+		else { // Bits stay packed until skeletonization
+			bit_mat bits;
+			thr.from_bitmap(original, bits);
+			ske.run(bits, skeleton, distance);
+		}
+		tra.run(orig, skeleton, distance, vect);
+		apx.run(vect);
+		return vect;
+	}
+
+	load_image(original);
+	v_image vect = v_image(orig.cols, orig.rows); // Vector output
+	thr.set_rgb_order(orig_rgb);
+	tra.set_rgb_order(orig_rgb);
+	til.set_rgb_order(orig_rgb);
 
-	if (*param_interactive) {
-		timer threshold_timer;
-		timer skeletonization_timer;
-		timer tracing_timer;
-		timer approximation_timer;
-		volatile int state = 2; // State of vectorizer, remembers in which step we are
-
-		while (state) { // state 0 = end
-			switch (state) {
-				case 2: // First step
-					zoom_imshow("Original", orig, true); // Show original color image
-					waitKey(1); // interactive == 1: wait until the key is pressed; interactive == 0: Continue after one milisecond
-
-					threshold_timer.start();
-					thr.run(orig, binary);
-					threshold_timer.stop();
-					log.log<log_level::info>("Threshold time: %fs\n", threshold_timer.read());
-					thr.interactive(step1_changed, (void*) &state);
-
-					state++; // ... and wait in odd state for Enter
-					break;
-				case 4:
-					skeletonization_timer.start();
-					ske.run(binary, skeleton, distance); // Second step -- skeletonization
-					skeletonization_timer.stop();
-					log.log<log_level::info>("Skeletonization time: %fs\n", skeletonization_timer.read());
-					ske.interactive(step2_changed, (void*) &state);
-
-					state++; // ... and wait in odd state for Enter
-					break;
-				case 6:
-					tracing_timer.start();
-					tra.run(orig, skeleton, distance, vect);
-					tracing_timer.stop();
-					log.log<log_level::info>("Tracing time: %fs\n", tracing_timer.read());
-
-					state++; // ... and wait in odd state for Enter
-					break;
-				case 8:
-					approximation_timer.start();
-					apx.run(vect);
-					approximation_timer.stop();
-					log.log<log_level::info>("Approximation time: %fs\n", approximation_timer.read());
-
-					state++; // ... and wait in odd state for Enter
-					break;
-				case 10:
-					state = 0;
-					break;
-				default:
-					int key = waitKey(1);
-					if (key >= 0) {
-						log.log<log_level::debug>("Key: %i\n", key);
-						state = interactive(state, key);
-					}
+	if (*param_interactive)
+		vectorize_interactive(thr, ske, tra, apx, vect);
+	else if (til.enabled()) { // Large image, do first three steps tile by tile
+		til.run(orig, vect);
+		apx.run(vect);
+	}
+	else if (cache.enabled()) { // Reuse threshold and skeleton computed by previous runs
+		uint64_t thr_key = cache.key(stage_cache::hash(orig, orig_rgb), thresholder::used_params); // Same bytes in other channel order are other image
+		uint64_t ske_key = cache.key(thr_key, skeletonizer::used_params);
+		std::vector<Mat> mats;
+		if (cache.load(ske_key, "ske", mats) && (mats.size() == 2)) {
+			skeleton = mats[0];
+			distance = mats[1];
+		}
+		else {
+			if (cache.load(thr_key, "thr", mats) && (mats.size() == 1))
+				binary = mats[0];
+			else {
+				thr.run(orig, binary);
+				cache.store(thr_key, "thr", {binary});
 			}
+			ske.run(binary, skeleton, distance); // Second step -- skeletonization
+			cache.store(ske_key, "ske", {skeleton, distance});
 		}
+		tra.run(orig, skeleton, distance, vect);
+		apx.run(vect);
 	}
 	else {
-		thr.run(orig, binary);
-		ske.run(binary, skeleton, distance); // Second step -- skeletonization
+		if (thr.filter_enabled() || !ske.bits_supported()) {
+			thr.run(orig, binary);
+			ske.run(binary, skeleton, distance); // Second step -- skeletonization
+		}
+		else { // Nothing changes thresholded image and skeletonizer works on bits, pass it bit-packed
+			bit_mat bits;
+			thr.threshold(orig, bits);
+			ske.run(bits, skeleton, distance);
+		}
 		tra.run(orig, skeleton, distance, vect);
 		apx.run(vect);
 	}
@@ -12,6 +12,11 @@
 #include "v_image.h"
 #include "vectorizer.h"
 #include "parameters.h"
+#include "stage_graph.h"
+#include "thresholder.h"
+#include "skeletonizer.h"
+#include "tracer.h"
+#include "approximation.h"
 #include <string>
 
 namespace vectorix {
@@ -20,23 +25,26 @@ namespace vectorix {
 class vectorizer_vectorix: public vectorizer {
 public:
 	virtual v_image vectorize(const pnm_image &image);
+	v_image vectorize_stream(FILE *fd); // Read binary PNM image from stream band by band (see stream_decoder.h)
 	vectorizer_vectorix(parameters &params): vectorizer(params) {
 		par->bind_param(param_custom_input_name, "file_input", (std::string) "");
 
 		par->add_comment("Interactive mode: 0: disable, 1: show windows and trackbars");
 		par->bind_param(param_interactive, "interactive", 1);
 	};
+	static void pnm_to_mat(const pnm_image &original, cv::Mat &mat); // Wrap PPM image data as OpenCV image without copying (RGB order)
 private:
 	std::string *param_custom_input_name;
 	int *param_interactive;
 
-	// Trackbar callback functions (passed as parameter to non-member function)
-	static void step1_changed(int, void *ptr);
-	static void step2_changed(int, void *ptr);
+	// Trackbar callback function (passed as parameter to non-member function)
+	static void params_changed(int, void *ptr);
 
-	int interactive(int state, int key); // Process key press and decide what to do
+	int interactive(int stage, int key, stage_graph &graph); // Process key press and decide what to do
+	void vectorize_interactive(thresholder &thr, skeletonizer &ske, tracer &tra, approximation &apx, v_image &vect); // Show windows, rerun stages after changes
 
 	cv::Mat orig;
+	bool orig_rgb = false; // Channel order of orig: RGB (PNM input) or BGR (loaded by OpenCV)
 	cv::Mat binary;
 	cv::Mat skeleton;
 	cv::Mat distance;